@@ -0,0 +1,271 @@
+// Vulkan 3DGS - Copyright (c) 2025 Alejandro Amat (github.com/AlejandroAmat) -
+// MIT Licensed
+
+// Headless device for the GPU benchmarks, on the renderer's VulkanContext,
+// BufferManager and GpuProfiler. Kernels get one descriptor set of storage
+// buffers; Run() records a command buffer, waits for it and collects the
+// stages it timed, so GpuProfiler's stats average over the runs
+
+#pragma once
+
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BufferManager.h"
+#include "GpuProfiler.h"
+#include "VulkanContext.h"
+
+#ifndef SHADER_DIR
+#define SHADER_DIR "Shaders/" // set by CMake to src/Shaders
+#endif
+
+class GpuBenchmark {
+ public:
+  struct Kernel {
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+  };
+
+  GpuBenchmark() : _context(VkExtent2D{1, 1}, 1) {
+    if (_context.InitContext() != 0)
+      throw std::runtime_error("No Vulkan device for the benchmark");
+    _device = _context.GetLogicalDevice();
+    _profiler.Init(_context.GetPhysicalDevice(), _device,
+                   _context.GetGraphicsFamily(), 1);
+    if (!_profiler.IsSupported())
+      throw std::runtime_error("Device has no timestamp queries");
+
+    VkDescriptorPoolSize poolSize = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 64};
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 16;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(_device, &poolInfo, nullptr, &_pool) !=
+        VK_SUCCESS)
+      throw std::runtime_error("Failed to create descriptor pool!");
+  }
+
+  ~GpuBenchmark() {
+    vkDeviceWaitIdle(_device);
+    for (const Kernel &kernel : _kernels) {
+      vkDestroyPipeline(_device, kernel.pipeline, nullptr);
+      vkDestroyPipelineLayout(_device, kernel.layout, nullptr);
+      vkDestroyDescriptorSetLayout(_device, kernel.setLayout, nullptr);
+    }
+    vkDestroyDescriptorPool(_device, _pool, nullptr);
+    _profiler.CleanUp();
+    _buffers.CleanupAllBuffers(_device);
+  }
+
+  const VkPhysicalDeviceLimits &Limits() {
+    vkGetPhysicalDeviceProperties(_context.GetPhysicalDevice(), &_properties);
+    return _properties.limits;
+  }
+  uint32_t MinSubgroupSize() const { return _context.GetMinSubgroupSize(); }
+  GpuProfiler &Profiler() { return _profiler; }
+
+  VkBuffer CreateBuffer(VkDeviceSize size) {
+    return _buffers.CreateBuffer(_device, _context.GetPhysicalDevice(), size,
+                                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                     VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                     VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  }
+  void DestroyBuffer(VkBuffer buffer) {
+    _buffers.DestroyBuffer(_device, buffer);
+  }
+
+  void Upload(VkBuffer buffer, const void *data, VkDeviceSize size) {
+    VkBuffer staging = CreateStaging(size);
+    std::memcpy(_buffers.MapBuffer(staging), data, size);
+    _buffers.copyBuffer(_device, size, staging, buffer,
+                        _context.GetCommandPool(), _context.GetGraphicsQueue());
+    _buffers.DestroyBuffer(_device, staging);
+  }
+
+  void Download(VkBuffer buffer, void *data, VkDeviceSize size) {
+    VkBuffer staging = CreateStaging(size);
+    _buffers.copyBuffer(_device, size, buffer, staging,
+                        _context.GetCommandPool(), _context.GetGraphicsQueue());
+    std::memcpy(data, _buffers.MapBuffer(staging), size);
+    _buffers.DestroyBuffer(_device, staging);
+  }
+
+  // Storage buffers at bindings 0..buffers.size()-1
+  Kernel CreateKernel(const std::string &shader,
+                      const std::vector<VkBuffer> &buffers, uint32_t pushBytes,
+                      const VkSpecializationInfo *specInfo = nullptr) {
+    Kernel kernel;
+    std::vector<VkDescriptorSetLayoutBinding> bindings(buffers.size());
+    for (uint32_t i = 0; i < bindings.size(); i++)
+      bindings[i] = {i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr};
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount = uint32_t(bindings.size());
+    setLayoutInfo.pBindings = bindings.data();
+    if (vkCreateDescriptorSetLayout(_device, &setLayoutInfo, nullptr,
+                                    &kernel.setLayout) != VK_SUCCESS)
+      throw std::runtime_error("Failed to create descriptor set layout!");
+
+    VkPushConstantRange pushRange = {VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                                     pushBytes};
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &kernel.setLayout;
+    layoutInfo.pushConstantRangeCount = pushBytes > 0 ? 1 : 0;
+    layoutInfo.pPushConstantRanges = &pushRange;
+    if (vkCreatePipelineLayout(_device, &layoutInfo, nullptr, &kernel.layout) !=
+        VK_SUCCESS)
+      throw std::runtime_error("Failed to create pipeline layout!");
+
+    std::vector<char> code = ReadFile(SHADER_DIR + shader);
+    VkShaderModuleCreateInfo moduleInfo = {};
+    moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize = code.size();
+    moduleInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+    VkShaderModule module;
+    if (vkCreateShaderModule(_device, &moduleInfo, nullptr, &module) !=
+        VK_SUCCESS)
+      throw std::runtime_error("Failed to create shader module!");
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = module;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.stage.pSpecializationInfo = specInfo;
+    pipelineInfo.layout = kernel.layout;
+    VkResult result = vkCreateComputePipelines(
+        _device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &kernel.pipeline);
+    vkDestroyShaderModule(_device, module, nullptr);
+    if (result != VK_SUCCESS)
+      throw std::runtime_error("Failed to create compute pipeline for " +
+                               shader);
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = _pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &kernel.setLayout;
+    if (vkAllocateDescriptorSets(_device, &allocInfo, &kernel.set) !=
+        VK_SUCCESS)
+      throw std::runtime_error("Failed to allocate descriptor set!");
+    _kernels.push_back(kernel);
+    Bind(kernel, buffers);
+    return kernel;
+  }
+
+  // Points the kernel's bindings at other buffers, between runs only
+  void Bind(const Kernel &kernel, const std::vector<VkBuffer> &buffers) {
+    std::vector<VkDescriptorBufferInfo> infos(buffers.size());
+    std::vector<VkWriteDescriptorSet> writes(buffers.size());
+    for (uint32_t i = 0; i < buffers.size(); i++) {
+      infos[i] = {buffers[i], 0, VK_WHOLE_SIZE};
+      writes[i] = {};
+      writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[i].dstSet = kernel.set;
+      writes[i].dstBinding = i;
+      writes[i].descriptorCount = 1;
+      writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      writes[i].pBufferInfo = &infos[i];
+    }
+    vkUpdateDescriptorSets(_device, uint32_t(writes.size()), writes.data(), 0,
+                           nullptr);
+  }
+
+  static void Dispatch(VkCommandBuffer commandBuffer, const Kernel &kernel,
+                       uint32_t groups, const void *push = nullptr,
+                       uint32_t pushBytes = 0) {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                      kernel.pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            kernel.layout, 0, 1, &kernel.set, 0, nullptr);
+    if (pushBytes > 0)
+      vkCmdPushConstants(commandBuffer, kernel.layout,
+                         VK_SHADER_STAGE_COMPUTE_BIT, 0, pushBytes, push);
+    vkCmdDispatch(commandBuffer, groups, 1, 1);
+  }
+
+  // Shader and transfer writes before the next dispatch or copy
+  static void Barrier(VkCommandBuffer commandBuffer) {
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask =
+        VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT |
+                            VK_ACCESS_SHADER_WRITE_BIT |
+                            VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr);
+  }
+
+  // Records body, submits it and waits. Stages body opened on Profiler()
+  // are collected into its stats
+  void Run(const std::function<void(VkCommandBuffer)> &body) {
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = _context.GetCommandPool();
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    VkCommandBuffer commandBuffer;
+    vkAllocateCommandBuffers(_device, &allocInfo, &commandBuffer);
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    _profiler.BeginFrame(commandBuffer, 0);
+    body(commandBuffer);
+    vkEndCommandBuffer(commandBuffer);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    if (vkQueueSubmit(_context.GetGraphicsQueue(), 1, &submitInfo,
+                      VK_NULL_HANDLE) != VK_SUCCESS)
+      throw std::runtime_error("Failed to submit benchmark commands!");
+    vkQueueWaitIdle(_context.GetGraphicsQueue());
+    vkFreeCommandBuffers(_device, _context.GetCommandPool(), 1,
+                         &commandBuffer);
+    _profiler.Collect(0);
+  }
+
+  // Average over the runs since the last ResetStats, negative if never timed
+  float AverageMs(const std::string &stage) const {
+    for (const GpuProfiler::StageStats &stats : _profiler.GetStats())
+      if (stats.name == stage)
+        return stats.avgMs;
+    return -1.0f;
+  }
+
+ private:
+  VkBuffer CreateStaging(VkDeviceSize size) {
+    return _buffers.CreateBuffer(_device, _context.GetPhysicalDevice(), size,
+                                 VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                     VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  }
+
+  VulkanContext _context; // destroyed last
+  VkDevice _device = VK_NULL_HANDLE;
+  VkPhysicalDeviceProperties _properties = {};
+  BufferManager _buffers;
+  GpuProfiler _profiler;
+  VkDescriptorPool _pool = VK_NULL_HANDLE;
+  std::vector<Kernel> _kernels;
+};
@@ -0,0 +1,124 @@
+// Vulkan 3DGS - Copyright (c) 2025 Alejandro Amat (github.com/AlejandroAmat) -
+// MIT Licensed
+
+// Loader throughput on a synthetic PLY:
+//   ply_loader_benchmark [numGaussians] [shDegree] [path]
+// Writes the file, loads it with every PLYReadMode and through the scene
+// cache, and reports MB/s.
+
+#include "PLYLoader.h"
+#include "SceneCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+static void WriteSyntheticPLY(const std::string &path, size_t numGaussians,
+                              int shDegree) {
+  const int restCoeffs = 3 * ((shDegree + 1) * (shDegree + 1) - 1);
+
+  std::ofstream file(path, std::ios::binary);
+  file << "ply\nformat binary_little_endian 1.0\n";
+  file << "element vertex " << numGaussians << "\n";
+  for (const char *name : {"x", "y", "z", "nx", "ny", "nz", "f_dc_0", "f_dc_1",
+                           "f_dc_2"})
+    file << "property float " << name << "\n";
+  for (int i = 0; i < restCoeffs; ++i)
+    file << "property float f_rest_" << i << "\n";
+  for (const char *name : {"opacity", "scale_0", "scale_1", "scale_2",
+                           "rot_0", "rot_1", "rot_2", "rot_3"})
+    file << "property float " << name << "\n";
+  file << "end_header\n";
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> record(17 + restCoeffs);
+  for (size_t i = 0; i < numGaussians; ++i) {
+    for (float &v : record)
+      v = dist(rng);
+    file.write(reinterpret_cast<const char *>(record.data()),
+               record.size() * sizeof(float));
+  }
+}
+
+int main(int argc, char **argv) {
+  size_t numGaussians = argc > 1 ? std::stoull(argv[1]) : 1000000;
+  int shDegree = argc > 2 ? std::stoi(argv[2]) : 3;
+  std::string path = argc > 3 ? argv[3] : "ply_loader_benchmark.ply";
+
+  WriteSyntheticPLY(path, numGaussians, shDegree);
+  std::ifstream probe(path, std::ios::binary | std::ios::ate);
+  double megabytes = double(probe.tellg()) / (1024.0 * 1024.0);
+  probe.close();
+
+  std::cout << "Synthetic PLY: " << numGaussians << " Gaussians, SH degree "
+            << shDegree << ", " << megabytes << " MB" << std::endl;
+
+  std::unique_ptr<GaussianBase> reference;
+  const std::pair<PLYReadMode, const char *> modes[] = {
+      {PLYReadMode::Stream, "stream"}, {PLYReadMode::Mapped, "mapped"}};
+  for (const auto &[mode, name] : modes) {
+    int degree = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    auto data = PLYLoader::LoadPLY(path, degree, mode);
+    auto end = std::chrono::high_resolution_clock::now();
+    if (!data) {
+      std::cerr << name << ": load failed" << std::endl;
+      return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ": " << seconds * 1000.0 << " ms, "
+              << megabytes / seconds << " MB/s" << std::endl;
+
+    if (!reference) {
+      reference = std::move(data);
+    } else if (data->_shCoefficients != reference->_shCoefficients ||
+               data->_opacities != reference->_opacities ||
+               data->_scales != reference->_scales ||
+               data->_rotations != reference->_rotations ||
+               data->_xyz != reference->_xyz) {
+      std::cerr << name << ": output differs from stream loader" << std::endl;
+      return 1;
+    }
+  }
+
+  std::string cachePath = SceneCache::CachePathFor(path);
+  if (!SceneCache::Write(cachePath, path, *reference)) {
+    std::cerr << "scene cache: write failed" << std::endl;
+    return 1;
+  }
+  auto start = std::chrono::high_resolution_clock::now();
+  auto cached = SceneCache::Load(cachePath, path);
+  auto end = std::chrono::high_resolution_clock::now();
+  if (!cached) {
+    std::cerr << "scene cache: load failed" << std::endl;
+    return 1;
+  }
+  double seconds = std::chrono::duration<double>(end - start).count();
+  std::cout << "scene cache: " << seconds * 1000.0 << " ms" << std::endl;
+
+  const size_t n = reference->GetCount();
+  const size_t shFloats = n * 3 * reference->GetSHCoefficientsPerChannel();
+  if (cached->GetCount() != n ||
+      cached->GetSHDegree() != reference->GetSHDegree() ||
+      std::memcmp(cached->GetPositionsData(), reference->GetPositionsData(),
+                  n * sizeof(glm::vec4)) != 0 ||
+      std::memcmp(cached->GetScalesData(), reference->GetScalesData(),
+                  n * sizeof(glm::vec4)) != 0 ||
+      std::memcmp(cached->GetRotationsData(), reference->GetRotationsData(),
+                  n * sizeof(glm::vec4)) != 0 ||
+      std::memcmp(cached->GetOpacitiesData(), reference->GetOpacitiesData(),
+                  n * sizeof(float)) != 0 ||
+      std::memcmp(cached->GetSHData(), reference->GetSHData(),
+                  shFloats * sizeof(float)) != 0) {
+    std::cerr << "scene cache: output differs from stream loader" << std::endl;
+    return 1;
+  }
+
+  cached.reset();
+  std::remove(cachePath.c_str());
+  std::remove(path.c_str());
+  return 0;
+}
@@ -0,0 +1,159 @@
+// Vulkan 3DGS - Copyright (c) 2025 Alejandro Amat (github.com/AlejandroAmat) -
+// MIT Licensed
+
+// Inclusive prefix sum of tilesTouched from 1M to 100M elements on the GPU:
+//   prefix_scan_benchmark [maxMillionElements] [runs]
+// "hillis" is the Hillis-Steele scan the tree used to run
+// (benchmarks/shaders/prefixsum_hillis.comp, one dispatch per step), "rts"
+// the reduce-then-scan in prefixsum.comp that replaced it. Both are timed
+// with timestamp queries around their dispatches, averaged over the runs,
+// and checked against a CPU scan. A size whose dispatch exceeds
+// maxComputeWorkGroupCount is skipped for that scan.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "GpuBenchmark.h"
+#include "utils.h"
+
+const uint32_t BLOCK_SIZE = 1024; // PREFIX_SUM_BLOCK_SIZE
+const uint32_t HILLIS_GROUP = 256;
+
+// Tiles touched per visible Gaussian, mostly small with a long tail
+static std::vector<uint32_t> MakeTiles(uint32_t count) {
+  std::vector<uint32_t> tiles(count);
+  uint64_t state = 0x9E3779B97F4A7C15ull;
+  for (uint32_t i = 0; i < count; i++) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    uint32_t r = uint32_t(state & 0xFF);
+    tiles[i] = r < 200 ? 1 + (r & 3) : 1 + (r & 63);
+  }
+  return tiles;
+}
+
+int main(int argc, char **argv) {
+  double maxMillions = argc > 1 ? std::atof(argv[1]) : 100.0;
+  int runs = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 20;
+  const double sizes[] = {1, 2, 5, 10, 20, 50, 100};
+
+  try {
+    GpuBenchmark gpu;
+    uint32_t maxGroups = gpu.Limits().maxComputeWorkGroupCount[0];
+
+    // Buffers for the largest size, smaller ones scan a prefix of them
+    uint32_t capacity = 0;
+    for (double millions : sizes)
+      if (millions <= maxMillions)
+        capacity = uint32_t(millions * 1e6);
+    if (capacity == 0)
+      return 0;
+    VkDeviceSize capacityBytes = VkDeviceSize(capacity) * sizeof(uint32_t);
+    std::vector<uint32_t> tiles = MakeTiles(capacity);
+    VkBuffer input = gpu.CreateBuffer(capacityBytes);
+    VkBuffer bufferA = gpu.CreateBuffer(capacityBytes);
+    VkBuffer bufferB = gpu.CreateBuffer(capacityBytes);
+    VkBuffer blockSums = gpu.CreateBuffer(
+        VkDeviceSize((capacity + BLOCK_SIZE - 1) / BLOCK_SIZE) * 4);
+    VkBuffer visibleArgs = gpu.CreateBuffer(sizeof(VisibleArgs));
+    gpu.Upload(input, tiles.data(), capacityBytes);
+
+    // prefixsum.comp: tilesTouched, prefixSum, blockSums, visibleArgs
+    GpuBenchmark::Kernel rts =
+        gpu.CreateKernel("sum.spv", {input, bufferB, blockSums, visibleArgs},
+                         sizeof(uint32_t));
+    GpuBenchmark::Kernel hillis = gpu.CreateKernel(
+        "prefixsum_hillis.spv", {bufferA, bufferB}, 3 * sizeof(uint32_t));
+
+    std::printf("%10s %15s %12s %10s %9s %8s\n", "elements", "hillis dispatch",
+                "rts dispatch", "hillis ms", "rts ms", "speedup");
+    for (double millions : sizes) {
+      if (millions > maxMillions)
+        break;
+      uint32_t count = uint32_t(millions * 1e6);
+      VkDeviceSize bytes = VkDeviceSize(count) * sizeof(uint32_t);
+      std::vector<uint32_t> reference(count), result(count);
+      uint32_t running = 0;
+      for (uint32_t i = 0; i < count; i++)
+        reference[i] = running += tiles[i];
+
+      // Reduce-then-scan, three dispatches
+      uint32_t blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+      float rtsMs = -1.0f;
+      if (blocks <= maxGroups) {
+        VisibleArgs args = {};
+        args.visibleCount = count;
+        gpu.Upload(visibleArgs, &args, sizeof(args));
+        gpu.Profiler().ResetStats();
+        for (int run = 0; run < runs; run++) {
+          gpu.Run([&](VkCommandBuffer commandBuffer) {
+            gpu.Profiler().BeginStage(commandBuffer, "rts");
+            for (uint32_t pass = 0; pass < 3; pass++) {
+              GpuBenchmark::Dispatch(commandBuffer, rts,
+                                     pass == 1 ? 1 : blocks, &pass,
+                                     sizeof(pass));
+              GpuBenchmark::Barrier(commandBuffer);
+            }
+            gpu.Profiler().EndStage(commandBuffer);
+          });
+        }
+        rtsMs = gpu.AverageMs("rts");
+        gpu.Download(bufferB, result.data(), bytes);
+        if (result != reference) {
+          std::printf("Reduce-then-scan wrong at %u elements\n", count);
+          return 1;
+        }
+      }
+
+      // Hillis-Steele, one dispatch per step. The input is copied into A
+      // before every run, outside the timed stage
+      uint32_t steps = 0;
+      while ((uint64_t(1) << steps) < count)
+        steps++;
+      uint32_t groups = (count + HILLIS_GROUP - 1) / HILLIS_GROUP;
+      float hillisMs = -1.0f;
+      if (groups <= maxGroups) {
+        gpu.Profiler().ResetStats();
+        for (int run = 0; run < runs; run++) {
+          gpu.Run([&](VkCommandBuffer commandBuffer) {
+            VkBufferCopy copy = {0, 0, bytes};
+            vkCmdCopyBuffer(commandBuffer, input, bufferA, 1, &copy);
+            GpuBenchmark::Barrier(commandBuffer);
+            gpu.Profiler().BeginStage(commandBuffer, "hillis");
+            for (uint32_t step = 0; step < steps; step++) {
+              uint32_t push[3] = {step, count, step % 2 == 0 ? 1u : 0u};
+              GpuBenchmark::Dispatch(commandBuffer, hillis, groups, push,
+                                     sizeof(push));
+              GpuBenchmark::Barrier(commandBuffer);
+            }
+            gpu.Profiler().EndStage(commandBuffer);
+          });
+        }
+        hillisMs = gpu.AverageMs("hillis");
+        gpu.Download(steps % 2 == 1 ? bufferB : bufferA, result.data(), bytes);
+        if (result != reference) {
+          std::printf("Hillis-Steele wrong at %u elements\n", count);
+          return 1;
+        }
+      }
+
+      char hillisText[32] = "-", rtsText[32] = "-", speedup[32] = "-";
+      if (hillisMs >= 0.0f)
+        std::snprintf(hillisText, sizeof(hillisText), "%.3f", hillisMs);
+      if (rtsMs >= 0.0f)
+        std::snprintf(rtsText, sizeof(rtsText), "%.3f", rtsMs);
+      if (hillisMs >= 0.0f && rtsMs > 0.0f)
+        std::snprintf(speedup, sizeof(speedup), "%.1fx", hillisMs / rtsMs);
+      std::printf("%10u %15u %12u %10s %9s %8s\n", count, steps, 3u,
+                  hillisText, rtsText, speedup);
+    }
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
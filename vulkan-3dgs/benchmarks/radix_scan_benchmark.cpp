@@ -0,0 +1,194 @@
+// Vulkan 3DGS - Copyright (c) 2025 Alejandro Amat (github.com/AlejandroAmat) -
+// MIT Licensed
+
+// Classic radix sort stages on the GPU from 1M to 100M keys:
+//   radix_scan_benchmark [maxMillionKeys] [walkLimitMillionKeys] [runs]
+// Sorts 32-bit keys with payload (histogram32, histogram_scan, sort32 as
+// ComputePipeline records them) and times each stage per pass with
+// timestamp queries. "walk" is the scatter before histogram_scan.comp
+// (sort_walk32.spv), every workgroup reading every histogram, timed the same
+// way after a plain histogram pass. Per key the scan's scatter stays flat
+// while the walk grows with the workgroup count. The walk is skipped above
+// the limit (default 20M keys), it is quadratic. Both results are checked
+// against std::sort.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <vector>
+
+#include "GpuBenchmark.h"
+
+const uint32_t BINS = 256;
+const uint32_t BLOCKS_PER_WORKGROUP = 32; // blocks_per_workgroup
+const uint32_t KEYS_PER_WORKGROUP = 256 * BLOCKS_PER_WORKGROUP;
+const uint32_t PASSES = 4; // 32-bit keys
+
+static std::vector<uint32_t> MakeKeys(uint32_t count) {
+  std::vector<uint32_t> keys(count);
+  uint64_t state = 0x9E3779B97F4A7C15ull;
+  for (uint32_t i = 0; i < count; i++) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    keys[i] = uint32_t(state >> 32);
+  }
+  return keys;
+}
+
+int main(int argc, char **argv) {
+  double maxMillions = argc > 1 ? std::atof(argv[1]) : 100.0;
+  double walkLimit = argc > 2 ? std::atof(argv[2]) : 20.0;
+  int runs = argc > 3 ? std::max(std::atoi(argv[3]), 1) : 10;
+  const double sizes[] = {1, 2, 5, 10, 20, 50, 100};
+
+  try {
+    GpuBenchmark gpu;
+
+    // Buffers for the largest size, smaller ones sort a prefix of them
+    uint32_t capacity = 0;
+    for (double millions : sizes)
+      if (millions <= maxMillions)
+        capacity = uint32_t(millions * 1e6);
+    if (capacity == 0)
+      return 0;
+    uint32_t maxWorkgroups =
+        (capacity + KEYS_PER_WORKGROUP - 1) / KEYS_PER_WORKGROUP;
+    VkDeviceSize capacityBytes = VkDeviceSize(capacity) * sizeof(uint32_t);
+    std::vector<uint32_t> keys = MakeKeys(capacity);
+    std::vector<uint32_t> payload(capacity);
+    std::iota(payload.begin(), payload.end(), 0u);
+
+    VkBuffer source = gpu.CreateBuffer(capacityBytes);
+    VkBuffer keysA = gpu.CreateBuffer(capacityBytes);
+    VkBuffer keysB = gpu.CreateBuffer(capacityBytes);
+    VkBuffer payloadA = gpu.CreateBuffer(capacityBytes);
+    VkBuffer payloadB = gpu.CreateBuffer(capacityBytes);
+    VkBuffer histograms =
+        gpu.CreateBuffer(VkDeviceSize(BINS) * (maxWorkgroups + 1) * 4);
+    VkBuffer dispatchArgs = gpu.CreateBuffer(sizeof(uint32_t) * 4);
+    gpu.Upload(source, keys.data(), capacityBytes);
+    gpu.Upload(payloadA, payload.data(), capacityBytes);
+
+    uint32_t minSubgroupSize = gpu.MinSubgroupSize();
+    VkSpecializationMapEntry specEntry = {0, 0, sizeof(uint32_t)};
+    VkSpecializationInfo specInfo = {1, &specEntry, sizeof(uint32_t),
+                                     &minSubgroupSize};
+
+    // Ping-pong: even passes read A and write B, odd passes the reverse
+    const uint32_t pushBytes = 2 * sizeof(uint32_t);
+    GpuBenchmark::Kernel histogram[2], scatter[2], walk[2];
+    VkBuffer keysIn[2] = {keysA, keysB}, payloadIn[2] = {payloadA, payloadB};
+    for (int i = 0; i < 2; i++) {
+      histogram[i] = gpu.CreateKernel(
+          "histogram32.spv", {keysIn[i], histograms, dispatchArgs}, pushBytes,
+          &specInfo);
+      std::vector<VkBuffer> scatterBuffers = {
+          keysIn[i],        keysIn[1 - i], payloadIn[i],
+          payloadIn[1 - i], histograms,    dispatchArgs};
+      scatter[i] = gpu.CreateKernel("sort32.spv", scatterBuffers, pushBytes,
+                                    &specInfo);
+      walk[i] = gpu.CreateKernel("sort_walk32.spv", scatterBuffers, pushBytes,
+                                 &specInfo);
+    }
+    GpuBenchmark::Kernel scan =
+        gpu.CreateKernel("histogram_scan.spv",
+                         {keysA, histograms, dispatchArgs}, pushBytes,
+                         &specInfo);
+
+    // Records one full sort, the scatter pass either after a scan or walking
+    auto recordSort = [&](VkCommandBuffer commandBuffer, uint32_t count,
+                          bool walkHistograms) {
+      VkBufferCopy copy = {0, 0, VkDeviceSize(count) * sizeof(uint32_t)};
+      vkCmdCopyBuffer(commandBuffer, source, keysA, 1, &copy);
+      GpuBenchmark::Barrier(commandBuffer);
+      uint32_t workgroups =
+          (count + KEYS_PER_WORKGROUP - 1) / KEYS_PER_WORKGROUP;
+      GpuProfiler &profiler = gpu.Profiler();
+      for (uint32_t pass = 0; pass < PASSES; pass++) {
+        uint32_t push[2] = {pass * 8, BLOCKS_PER_WORKGROUP};
+        int side = pass % 2;
+        profiler.BeginStage(commandBuffer, "histogram");
+        GpuBenchmark::Dispatch(commandBuffer, histogram[side], workgroups,
+                               push, pushBytes);
+        GpuBenchmark::Barrier(commandBuffer);
+        profiler.EndStage(commandBuffer);
+        if (walkHistograms) {
+          profiler.BeginStage(commandBuffer, "walk scatter");
+          GpuBenchmark::Dispatch(commandBuffer, walk[side], workgroups, push,
+                                 pushBytes);
+        } else {
+          profiler.BeginStage(commandBuffer, "scan");
+          GpuBenchmark::Dispatch(commandBuffer, scan, BINS, push, pushBytes);
+          GpuBenchmark::Barrier(commandBuffer);
+          profiler.EndStage(commandBuffer);
+          profiler.BeginStage(commandBuffer, "scatter");
+          GpuBenchmark::Dispatch(commandBuffer, scatter[side], workgroups,
+                                 push, pushBytes);
+        }
+        GpuBenchmark::Barrier(commandBuffer);
+        profiler.EndStage(commandBuffer);
+      }
+    };
+
+    std::printf("%10s %10s %10s %9s %11s %12s %11s %12s\n", "keys",
+                "workgroups", "hist ms", "scan ms", "scatter ms",
+                "scatter ns/k", "walk ms", "walk ns/k");
+    for (double millions : sizes) {
+      if (millions > maxMillions)
+        break;
+      uint32_t count = uint32_t(millions * 1e6);
+      uint32_t workgroups =
+          (count + KEYS_PER_WORKGROUP - 1) / KEYS_PER_WORKGROUP;
+      uint32_t args[4] = {count, count, workgroups, 0};
+      gpu.Upload(dispatchArgs, args, sizeof(args));
+
+      std::vector<uint32_t> reference(keys.begin(), keys.begin() + count);
+      std::sort(reference.begin(), reference.end());
+      std::vector<uint32_t> result(count);
+      VkDeviceSize bytes = VkDeviceSize(count) * sizeof(uint32_t);
+
+      gpu.Profiler().ResetStats();
+      for (int run = 0; run < runs; run++)
+        gpu.Run([&](VkCommandBuffer commandBuffer) {
+          recordSort(commandBuffer, count, false);
+        });
+      // Averages are per pass
+      float histogramMs = gpu.AverageMs("histogram");
+      float scanMs = gpu.AverageMs("scan");
+      float scatterMs = gpu.AverageMs("scatter");
+      gpu.Download(keysA, result.data(), bytes);
+      if (result != reference) {
+        std::printf("Sort wrong at %u keys\n", count);
+        return 1;
+      }
+
+      char walkMs[32] = "-", walkNs[32] = "-";
+      if (millions <= walkLimit) {
+        gpu.Profiler().ResetStats();
+        for (int run = 0; run < runs; run++)
+          gpu.Run([&](VkCommandBuffer commandBuffer) {
+            recordSort(commandBuffer, count, true);
+          });
+        float ms = gpu.AverageMs("walk scatter");
+        gpu.Download(keysA, result.data(), bytes);
+        if (result != reference) {
+          std::printf("Walking sort wrong at %u keys\n", count);
+          return 1;
+        }
+        std::snprintf(walkMs, sizeof(walkMs), "%.3f", ms);
+        std::snprintf(walkNs, sizeof(walkNs), "%.3f", ms * 1e6 / count);
+      }
+
+      std::printf("%10u %10u %10.3f %9.3f %11.3f %12.3f %11s %12s\n", count,
+                  workgroups, histogramMs, scanMs, scatterMs,
+                  scatterMs * 1e6 / count, walkMs, walkNs);
+    }
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,220 @@
+// Vulkan 3DGS - Copyright (c) 2025 Alejandro Amat (github.com/AlejandroAmat) -
+// MIT Licensed
+
+// Splat extent modes on synthetic screen-space Gaussians:
+//   tile_extent_benchmark [numGaussians] [width] [height]
+// CPU mirror of preprocess.comp / idkeys.comp / render.comp. For each mode
+// reports keys per visible Gaussian and the image difference against the
+// current 3-sigma bounding box.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+const int TILE = 16;
+
+struct Splat {
+  glm::vec2 center;
+  glm::vec3 conic;
+  glm::vec2 cov; // diagonal of the 2D covariance
+  float det;
+  float opacity;
+  float depth;
+  glm::vec3 color;
+};
+
+struct Mode {
+  const char *name;
+  bool exactTiles;
+  bool opacityRadius;
+};
+
+// Same closed form as ellipseRectMin in preprocess.comp
+static float EllipseRectMin(glm::vec3 conic, glm::vec2 lo, glm::vec2 hi) {
+  if (lo.x <= 0.0f && hi.x >= 0.0f && lo.y <= 0.0f && hi.y >= 0.0f)
+    return 0.0f;
+  auto q = [&](float dx, float dy) {
+    return conic.x * dx * dx + 2.0f * conic.y * dx * dy + conic.z * dy * dy;
+  };
+  float best = 3.402823e38f;
+  for (int e = 0; e < 2; e++) {
+    float dx = e == 0 ? lo.x : hi.x;
+    best = std::min(best, q(dx, std::clamp(-conic.y * dx / conic.z, lo.y,
+                                           hi.y)));
+    float dy = e == 0 ? lo.y : hi.y;
+    best = std::min(best, q(std::clamp(-conic.y * dy / conic.x, lo.x, hi.x),
+                            dy));
+  }
+  return best;
+}
+
+static float ExtentSigmas(float opacity, bool opacityRadius) {
+  if (!opacityRadius)
+    return 3.0f;
+  return std::min(3.0f,
+                  std::sqrt(2.0f * std::log(std::max(255.0f * opacity, 1.0f))));
+}
+
+static std::vector<Splat> MakeSplats(size_t n, int width, int height) {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+  std::normal_distribution<float> logit(-1.0f, 2.0f);
+
+  std::vector<Splat> splats(n);
+  for (Splat &s : splats) {
+    // Log-uniform axes from sub-pixel to a few tiles, random orientation
+    float s1 = std::exp(uni(rng) * 4.0f - 1.0f);
+    float s2 = s1 * std::exp(-uni(rng) * 3.0f);
+    float theta = uni(rng) * 3.14159265f;
+    float c = std::cos(theta), sn = std::sin(theta);
+    glm::vec3 cov(c * c * s1 * s1 + sn * sn * s2 * s2,
+                  c * sn * (s1 * s1 - s2 * s2),
+                  sn * sn * s1 * s1 + c * c * s2 * s2);
+    cov.x += 0.3f; // low-pass filter as in computeCov2D
+    cov.z += 0.3f;
+
+    s.det = cov.x * cov.z - cov.y * cov.y;
+    s.conic = glm::vec3(cov.z, -cov.y, cov.x) / s.det;
+    s.cov = glm::vec2(cov.x, cov.z);
+    s.center = glm::vec2(uni(rng) * width, uni(rng) * height);
+    s.opacity = 1.0f / (1.0f + std::exp(-logit(rng)));
+    s.depth = uni(rng);
+    s.color = glm::vec3(uni(rng), uni(rng), uni(rng));
+  }
+  std::sort(splats.begin(), splats.end(),
+            [](const Splat &a, const Splat &b) { return a.depth < b.depth; });
+  return splats;
+}
+
+// Returns the keys emitted and the number of visible splats
+static size_t BuildTileLists(const std::vector<Splat> &splats, int width,
+                             int height, const Mode &mode,
+                             std::vector<std::vector<uint32_t>> &tiles,
+                             size_t &visible) {
+  int gridX = (width + TILE - 1) / TILE;
+  int gridY = (height + TILE - 1) / TILE;
+  tiles.assign(size_t(gridX) * gridY, {});
+  size_t keys = 0;
+  visible = 0;
+
+  // Depth sorted already, so per-tile lists come out in render order
+  for (uint32_t i = 0; i < splats.size(); i++) {
+    const Splat &s = splats[i];
+    if (mode.opacityRadius && s.opacity < 1.0f / 255.0f)
+      continue;
+    float sigmas = ExtentSigmas(s.opacity, mode.opacityRadius);
+
+    float mid = 0.5f * (s.cov.x + s.cov.y);
+    float lambda = mid + std::sqrt(std::max(0.1f, mid * mid - s.det));
+    float radius = std::ceil(sigmas * std::sqrt(lambda));
+
+    int minX = std::min(gridX, std::max(0, int((s.center.x - radius) / TILE)));
+    int minY = std::min(gridY, std::max(0, int((s.center.y - radius) / TILE)));
+    int maxX = std::min(
+        gridX, std::max(0, int((s.center.x + radius + TILE - 1) / TILE)));
+    int maxY = std::min(
+        gridY, std::max(0, int((s.center.y + radius + TILE - 1) / TILE)));
+    if ((maxX - minX) * (maxY - minY) == 0)
+      continue;
+    visible++;
+
+    bool exact = mode.exactTiles && (maxX - minX) * (maxY - minY) > 1;
+    for (int y = minY; y < maxY; y++) {
+      for (int x = minX; x < maxX; x++) {
+        glm::vec2 tileMin(x * TILE, y * TILE);
+        glm::vec2 tileMax = tileMin + glm::vec2(TILE - 1);
+        if (exact && EllipseRectMin(s.conic, tileMin - s.center,
+                                    tileMax - s.center) > sigmas * sigmas)
+          continue;
+        tiles[size_t(y) * gridX + x].push_back(i);
+        keys++;
+      }
+    }
+  }
+  return keys;
+}
+
+// render.comp, one pixel at a time
+static void Render(const std::vector<Splat> &splats,
+                   const std::vector<std::vector<uint32_t>> &tiles, int width,
+                   int height, std::vector<glm::vec3> &image) {
+  int gridX = (width + TILE - 1) / TILE;
+  image.assign(size_t(width) * height, glm::vec3(0.0f));
+  for (int py = 0; py < height; py++) {
+    for (int px = 0; px < width; px++) {
+      const auto &list = tiles[size_t(py / TILE) * gridX + px / TILE];
+      float T = 1.0f;
+      glm::vec3 C(0.0f);
+      for (uint32_t i : list) {
+        const Splat &s = splats[i];
+        glm::vec2 d = s.center - glm::vec2(px, py);
+        float power = -0.5f * (s.conic.x * d.x * d.x + s.conic.z * d.y * d.y) -
+                      s.conic.y * d.x * d.y;
+        if (power > 0.0f)
+          continue;
+        float alpha = std::min(0.99f, s.opacity * std::exp(power));
+        if (alpha < 1.0f / 255.0f)
+          continue;
+        float testT = T * (1.0f - alpha);
+        if (testT < 0.0001f)
+          break;
+        C += s.color * alpha * T;
+        T = testT;
+      }
+      image[size_t(py) * width + px] = C;
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  size_t numGaussians = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+  int width = argc > 2 ? std::atoi(argv[2]) : 1280;
+  int height = argc > 3 ? std::atoi(argv[3]) : 720;
+
+  auto splats = MakeSplats(numGaussians, width, height);
+  std::printf("%zu synthetic splats, %dx%d, %dpx tiles\n", numGaussians, width,
+              height, TILE);
+
+  const Mode modes[] = {{"3-sigma box", false, false},
+                        {"3-sigma ellipse", true, false},
+                        {"opacity box", false, true},
+                        {"opacity ellipse", true, true}};
+
+  std::vector<glm::vec3> reference;
+  for (const Mode &mode : modes) {
+    std::vector<std::vector<uint32_t>> tiles;
+    size_t visible = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t keys = BuildTileLists(splats, width, height, mode, tiles, visible);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::vector<glm::vec3> image;
+    Render(splats, tiles, width, height, image);
+    if (reference.empty())
+      reference = image;
+
+    double sqError = 0.0, maxError = 0.0;
+    for (size_t p = 0; p < image.size(); p++) {
+      for (int c = 0; c < 3; c++) {
+        double e = double(image[p][c]) - double(reference[p][c]);
+        sqError += e * e;
+        maxError = std::max(maxError, std::abs(e));
+      }
+    }
+    double mse = sqError / double(image.size() * 3);
+    double psnr = mse > 0.0 ? 10.0 * std::log10(1.0 / mse) : INFINITY;
+
+    std::printf("%-16s %10zu keys  %6.2f keys/visible  %7.1f ms  PSNR %6.1f dB"
+                "  max diff %.4f\n",
+                mode.name, keys, double(keys) / double(std::max<size_t>(visible, 1)),
+                std::chrono::duration<double, std::milli>(end - start).count(),
+                psnr, maxError);
+  }
+  return 0;
+}
@@ -4,9 +4,11 @@
 #include <iostream>
 #include <optional>
 
+#include "BatchRenderer.h"
 #include "GaussianRenderer.h"
 #include "Imgui3DGS.h"
 #include "PLYLoader.h"
+#include "SceneCache.h"
 #include "Sequence.h"
 #include "VulkanContext.h"
 #include "Window.h"
@@ -17,12 +19,31 @@ class Application {
       : _pointCloudFile(args.ply),
         _windowManager("3DGS Vulkan", args.w, args.h),
         _frameTimer(),
-        _seqRecorder() {}
+        _seqRecorder(),
+        _headless(args.headless),
+        _width(args.w),
+        _height(args.h),
+        _framesLeft(args.frames),
+        _outputPrefix(args.output),
+        _batchModel(args.batch) {
+    g_renderSettings.shStorage = args.shStorage;
+    g_renderSettings.covStorage = args.covStorage;
+  }
   void Start();
   void Render();
-  bool IsRunning() const { return _windowManager.IsActive(); }
+  bool IsRunning() const {
+    return _headless ? _framesLeft > 0 : _windowManager.IsActive();
+  }
+
+  // .3dgsbin directly, or a PLY through its scene cache
+  static std::unique_ptr<GaussianBase> LoadScene(const std::string &path);
 
  private:
+  // Binary PPM, alpha dropped
+  static bool WriteImage(const std::string &path, const ReadbackFrame &frame);
+  // Every view of the COLMAP model, <output>/<image name>.ppm
+  void RenderBatch();
+
   const std::string _pointCloudFile;
   int _degree = 0;
   FrameTimer _frameTimer;
@@ -31,4 +52,11 @@ class Application {
   std::optional<VulkanContext> _vkContext;
   std::optional<GaussianRenderer> _renderPipeline;
   Sequence _seqRecorder;
+
+  const bool _headless;
+  int _width, _height; // 0 in batch mode until the views are loaded
+  int _framesLeft;
+  const std::string _outputPrefix;
+  const std::string _batchModel;
+  std::vector<BatchView> _batchViews;
 };
\ No newline at end of file
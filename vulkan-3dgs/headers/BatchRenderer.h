@@ -0,0 +1,63 @@
+// Vulkan 3DGS - Copyright (c) 2025 Alejandro Amat (github.com/AlejandroAmat) -
+// MIT Licensed
+
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "GaussianRenderer.h"
+
+// Pinhole view in COLMAP conventions: world to camera rotation and
+// translation, camera x right, y down, z forward, pixel centers at +0.5
+struct BatchView {
+  std::string name; // image name, used for the output file
+  uint32_t width;   // size the intrinsics are given for
+  uint32_t height;
+  float fx, fy, cx, cy;
+  glm::mat3 rotation;
+  glm::vec3 translation;
+};
+
+struct BatchOptions {
+  float nearPlane = 0.01f;
+  float farPlane = 1000.0f;
+  // Re-renders of a view whose keys did not fit, the sort buffers grow in
+  // between. After that the image is delivered with the farthest keys cut
+  uint32_t maxRetries = 2;
+};
+
+struct BatchStats {
+  uint32_t views = 0;
+  uint32_t frames = 0; // submitted, retries included
+  uint32_t incomplete = 0;
+  double seconds = 0.0;
+};
+
+// Renders many poses of the loaded scene through the GPU driven frame: one
+// submission per view with frames_in_flight of them queued, so preprocess,
+// sort and raster of the next pose overlap the readback of the last one.
+// Scene buffers are shared by every view
+class BatchRenderer {
+ public:
+  using ImageCallback = std::function<void(
+      size_t viewIndex, const BatchView &view, const ReadbackFrame &frame)>;
+
+  explicit BatchRenderer(GaussianRenderer &renderer) : _renderer(renderer) {}
+
+  // Images arrive in submission order. Headless context only
+  BatchStats Run(const std::vector<BatchView> &views,
+                 const ImageCallback &onImage,
+                 const BatchOptions &options = {});
+
+  // Intrinsics scaled to the render size when the view was given for another
+  static CameraUniforms MakeUniforms(const BatchView &view, uint32_t width,
+                                     uint32_t height, float nearPlane,
+                                     float farPlane);
+
+  // cameras.txt and images.txt of a COLMAP text model. Distortion is ignored
+  static std::vector<BatchView> LoadColmapViews(const std::string &modelDir);
+
+ private:
+  GaussianRenderer &_renderer;
+};
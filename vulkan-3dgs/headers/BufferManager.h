@@ -6,8 +6,28 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <map>
+#include <unordered_map>
 #include <vector>
 
+// Device memory is reserved in blocks of this size per memory type and
+// buffers are bound to aligned sub-ranges of them. Larger buffers get a
+// dedicated block
+const VkDeviceSize ARENA_BLOCK_SIZE = 256ull * 1024 * 1024;
+const VkDeviceSize ARENA_HOST_BLOCK_SIZE = 4ull * 1024 * 1024;
+
+struct BufferMemoryStats {
+  uint32_t blockCount = 0;
+  uint32_t bufferCount = 0;
+  VkDeviceSize reservedBytes = 0; // sum of block sizes
+  VkDeviceSize usedBytes = 0;     // bound to live buffers, alignment included
+  VkDeviceSize freeBytes = 0;
+  VkDeviceSize largestFreeRange = 0;
+  uint32_t freeRanges = 0;
+  // 0 when all free memory is one range, towards 1 as it splinters
+  float fragmentation = 0.0f;
+};
+
 class BufferManager {
 public:
   BufferManager(){};
@@ -29,23 +49,52 @@ public:
   void DestroyBuffer(VkDevice device, VkBuffer buffer);
   void copyBuffer(VkDevice device, VkDeviceSize deviceSize, VkBuffer srcBuffer,
                   VkBuffer dstBuffer, VkCommandPool transferPool,
-                  VkQueue transferQueue);
+                  VkQueue transferQueue, VkDeviceSize srcOffset = 0,
+                  VkDeviceSize dstOffset = 0);
 
-  VkDeviceMemory GetBufferMemory(VkBuffer buffer);
+  // Host visible blocks stay mapped, so this is a plain pointer lookup
+  void *MapBuffer(VkBuffer buffer);
+
+  // Returns the memory of blocks no buffer lives in anymore to the driver.
+  // This is not a defragmentation: live buffers are never moved (descriptor
+  // sets hold their handles), so free ranges inside used blocks stay as
+  // they are. GetMemoryStats reports how fragmented those are
+  void ReleaseEmptyBlocks(VkDevice device);
+  BufferMemoryStats GetMemoryStats() const;
 
 private:
-  void CreateBufferInternal(VkDevice device, VkPhysicalDevice physicalDevice,
-                            VkDeviceSize size, VkBufferUsageFlags usage,
-                            VkMemoryPropertyFlags properties, VkBuffer &buffer,
-                            VkDeviceMemory &bufferMemory);
+  struct MemoryBlock {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    uint32_t memoryType = 0;
+    VkDeviceSize size = 0;
+    VkDeviceSize used = 0;
+    bool dedicated = false; // released as soon as its buffer is
+    void *mapped = nullptr;
+    std::map<VkDeviceSize, VkDeviceSize> freeRanges; // offset -> size
+  };
 
   struct BufferInfo {
-    VkBuffer buffer;
-    VkDeviceMemory memory;
+    uint32_t block;
+    VkDeviceSize offset; // start of the range, before alignment
+    VkDeviceSize rangeSize;
+    VkDeviceSize bindOffset;
     VkDeviceSize size;
   };
 
-  std::vector<BufferInfo> _buffers;
+  void CreateBufferInternal(VkDevice device, VkPhysicalDevice physicalDevice,
+                            VkDeviceSize size, VkBufferUsageFlags usage,
+                            VkMemoryPropertyFlags properties, VkBuffer &buffer,
+                            BufferInfo &info);
+  // First fit over the free ranges of one block
+  bool AllocateRange(uint32_t blockIndex, const VkMemoryRequirements &memReq,
+                     BufferInfo &info);
+  uint32_t CreateBlock(VkDevice device, VkPhysicalDevice physicalDevice,
+                       uint32_t memoryType, VkDeviceSize size);
+  void FreeRange(const BufferInfo &info);
+  void ReleaseBlock(VkDevice device, uint32_t blockIndex);
+
+  std::vector<MemoryBlock> _blocks;
+  std::unordered_map<VkBuffer, BufferInfo> _buffers;
 
   uint32_t FindMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter,
                           VkMemoryPropertyFlags properties);
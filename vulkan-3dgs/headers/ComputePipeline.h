@@ -5,19 +5,28 @@
 
 #include "BufferManager.h"
 #include "Camera.h"
+#include "GpuProfiler.h"
 #include "Imgui3DGS.h"
 #include "VulkanContext.h"
 #include "glm/glm.hpp"
 #include "utils.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
 #include <iostream>
 #include <map>
-#define NOT_SHARED_MEM_RENDERING
 #include "GraphicsPipeline.h"
 #include "RenderSettings.h"
 
 const uint32_t WORKGROUP_SIZE = 256;
 const uint32_t RADIX_SORT_BINS = 256;
 const uint32_t blocks_per_workgroup = 32;
+const uint32_t PREFIX_SUM_BLOCK_SIZE = 1024; // 256 threads * 4 items
+// Onesweep histograms buffer (in uints), see radix_sort/onesweep.comp:
+// [global histogram MAX_PASSES * BINS | partition counters | lookback status]
+const uint32_t ONESWEEP_MAX_PASSES = 8;
+const uint32_t ONESWEEP_STATUS_OFFSET = (ONESWEEP_MAX_PASSES + 1) * 256;
 constexpr int frames_in_flight = 2;
 
 struct DescriptorBinding {
@@ -36,6 +45,7 @@ enum class PipelineType {
   PREPROCESS,
   PREFIXSUM,
   ASSIGN_TILE_IDS,
+  ASSIGN_TILE_IDS_1,
   NEAREST,
   RADIX_HISTOGRAM_0,
   RADIX_HISTOGRAM_1,
@@ -43,9 +53,28 @@ enum class PipelineType {
   RADIX_SCATTER_1,
   TILE_BOUNDARIES,
   RENDER,
-  UPSAMPLING
+  UPSAMPLING,
+  DISPATCH_ARGS,
+  ONESWEEP_HISTOGRAM,
+  ONESWEEP_SCATTER,
+  DEPTH_BUDGET,
+  RENDER_SHARED,        // RENDER layout, render_shared_mem.comp
+  RENDER_SHARED_SUBTILE, // same with four workgroups per tile
+  RADIX_SCAN,            // RADIX_HISTOGRAM_0 layout, histogram_scan.comp
+  COVARIANCE,            // 3D covariance cache, covariance.comp
+  CLUSTER_CULL           // preprocess workgroups, cluster_cull.comp
 };
 
+// Headless frame handed back once its fence signalled
+struct ReadbackFrame {
+  uint64_t frame; // RenderFrame call that produced it, counted from 1
+  uint32_t width;
+  uint32_t height;
+  const uint8_t *rgba; // mapped readback memory, valid during the callback
+  uint32_t droppedKeys; // cut by the splat budget, the image is incomplete
+};
+using ReadbackCallback = std::function<void(const ReadbackFrame &)>;
+
 class ComputePipeline {
 public:
   ComputePipeline(VulkanContext &vkContext, ImguiUI &imguiHandler,
@@ -59,12 +88,27 @@ public:
   void CleanUp();
   void setNumGaussians(int gauss) {
     _numGaussians = gauss;
-    //_sizeBufferMax = gauss * AVG_GAUSS_TILE;
-    _numSteps = static_cast<uint32_t>(std::ceil(std::log2(_numGaussians)));
+    // Matches the sort buffers GaussianRenderer allocates
+    _sizeBufferMax = uint32_t(gauss) * INITIAL_KEYS_PER_GAUSSIAN;
   }
+  // Bytes of the radix histograms buffer for numWorkgroups sort workgroups
+  static VkDeviceSize getHistogramSize(uint32_t numWorkgroups);
   void setBufferManager(BufferManager *bufferManager) {
     _buffManager = bufferManager;
   };
+  void SetCameraUniforms(const CameraUniforms &uniforms) {
+    _cameraUniforms = uniforms;
+  }
+  // Per-stage GPU times, a few frames late
+  const GpuProfiler &GetProfiler() const { return _profiler; }
+
+  // Headless: every frame is copied to host memory and delivered
+  // frames_in_flight frames later, or by FlushReadbacks
+  void SetReadbackCallback(ReadbackCallback callback) {
+    _readbackCallback = std::move(callback);
+  }
+  void FlushReadbacks();
+  uint64_t GetFrameNumber() const { return _frameNumber; }
 
 private:
   VulkanContext &_vkContext;
@@ -83,6 +127,7 @@ private:
 
   std::map<PipelineType, VkPipelineLayout> _pipelineLayouts;
   std::map<PipelineType, VkPipeline> _computePipelines;
+  std::map<PipelineType, VkPipeline> _computePipelines32;
   uint32_t _currentFrame = 0;
 
   void CreateCommandBuffers();
@@ -90,10 +135,46 @@ private:
   void CreateDescriptorSetLayout(const PipelineType pType);
   void CreateDescriptorPool();
   void CreateComputePipeline(std::string shaderName, const PipelineType pType,
-                             int numPushConstants = 0);
+                             int numPushConstants = 0,
+                             const VkSpecializationInfo *specInfo = nullptr);
+  // Same layout as pType, built from a 32-bit sort key shader variant
+  void CreateComputePipelineKey32(std::string shaderName,
+                                  const PipelineType pType,
+                                  const VkSpecializationInfo *specInfo = nullptr);
+  // Pipeline stored as pType that reuses the layout of layoutType
+  void CreateSharedLayoutPipeline(std::string shaderName,
+                                  const PipelineType pType,
+                                  const PipelineType layoutType, bool key32,
+                                  const VkSpecializationInfo *specInfo);
+  void CreateSortSpecialization();
+  void CreatePreprocessSpecialization();
+  void CreateTileSpecialization();
+  void RebuildTilePipelines();
   void SetupDescriptorSet(const PipelineType pType);
   void RecordCommandPreprocess(uint32_t imageIndex);
   void RecordCommandRender(uint32_t imageIndex, int numRendered, Camera &cam);
+  // GPU driven path: preprocess + render in one command buffer, sort and
+  // boundaries dispatched indirectly from the dispatch args buffer
+  void RecordCommandFrame(uint32_t imageIndex, Camera &cam);
+  void RecordPreprocessPass(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+  // Rebuilds the 3D covariance cache, at load and on scale modifier changes
+  void RecordCovariancePass(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+  void RecordRenderPass(VkCommandBuffer commandBuffer, uint32_t imageIndex,
+                        int numRendered, Camera &cam, bool indirect);
+  void RecordDispatchArgs(VkCommandBuffer commandBuffer, uint32_t imageIndex,
+                          bool overBudget);
+  void RecordKeyCountReadback(VkCommandBuffer commandBuffer);
+  void UpdateTileStats();
+  void CollectGpuTimings(uint32_t frame);
+  void CreateReadbackBuffers();
+  void RecordImageReadback(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+  void DeliverReadback(uint32_t frame);
+  // Offscreen image of this frame, or the acquired swapchain image
+  uint32_t AcquireImage();
+  void PresentImage(uint32_t imageIndex);
+  void RecordOnesweepSort(VkCommandBuffer commandBuffer, uint32_t imageIndex,
+                          uint32_t radixPasses, bool indirect,
+                          uint32_t numWorkgroups);
   VkShaderModule CreateShaderModule(const std::vector<char> &code);
 
   void TransitionImage(VkCommandBuffer commandBuffer, VkImageLayout in,
@@ -101,6 +182,7 @@ private:
                        VkAccessFlags dst, VkPipelineStageFlagBits srcStage,
                        VkPipelineStageFlagBits dstStage);
   void UpdateAllDescriptorSets(const PipelineType pType);
+  void UpdateDescriptorSets(const PipelineType pType, uint32_t i);
   void RecordAllCommandBuffers();
   void BindImageToDescriptor(const PipelineType pType, uint32_t i,
                              VkImageView view, uint32_t binding);
@@ -111,9 +193,18 @@ private:
 
   VkBuffer GetBufferByName(const std::string &bufferName);
 
-  void submitCommandBuffer(uint32_t imageIndex, bool waitSem = true);
+  void submitCommandBuffer(VkCommandBuffer commandBuffer, bool waitAcquire,
+                           bool signalRender, uint32_t imageIndex,
+                           VkFence fence);
+  void RenderFrameGpuDriven(Camera &cam);
   int getRadixIterations();
-  void resizeBuffers(float size);
+  uint32_t getNumTiles();
+  uint32_t getTileBits();
+  void resizeBuffers(uint32_t capacity);
+  uint32_t ChooseSortCapacity(uint32_t requested);
+  uint32_t SortCapacityCap();
+  void RefreshSortDescriptors(uint32_t imageIndex);
+  void ReleaseRetiredBuffers();
   void SetUpRadixBuffers();
   void RecordImGuiRenderPass(VkCommandBuffer commandBuffer, uint32_t imageIndex,
                              Camera &cam);
@@ -135,10 +226,6 @@ private:
          "outputImage"},
         {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
          "xyz"},
-        {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
-         "scales"},
-        {3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
-         "rotations"},
         {4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
          "opacity"},
         {5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
@@ -158,7 +245,39 @@ private:
         {12, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
          "tilesTouched"},
         {13, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
-         "boundingBox"}}},
+         "boundingBox"},
+        {14, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "tileStats"},
+        {15, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "visibleIndices"},
+        {16, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "visibleArgs"},
+        {17, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "covariance3D"},
+        {18, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "clusterOrder"},
+        {19, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "visibleClusters"}}},
+
+      {PipelineType::COVARIANCE,
+       {{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "scales"},
+        {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "rotations"},
+        {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "covariance3D"}}},
+
+      {PipelineType::CLUSTER_CULL,
+       {{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "clusters"},
+        {1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "camUniform"},
+        {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "visibleClusters"},
+        {3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "visibleArgs"},
+        {4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "tileStats"}}},
 
       {PipelineType::NEAREST,
        {{0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, 1,
@@ -180,7 +299,11 @@ private:
        {{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
          "tilesTouched"},
         {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
-         "tilesTouchedPrefixSum"}}},
+         "tilesTouchedPrefixSum"},
+        {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "prefixBlockSums"},
+        {3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "visibleArgs"}}},
 
       {PipelineType::ASSIGN_TILE_IDS,
        {{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
@@ -188,25 +311,81 @@ private:
         {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
          "depths"},
         {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
-         "radii"},
+         "visibleIndices"},
         {3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
          "boundingBox"},
         {4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
          "keys"},
         {5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
-         "values"}}},
+         "values"},
+        {6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "dispatchArgs"},
+        {7, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "conicOpacity"},
+        {8, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "pointsXY"},
+        {9, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "visibleArgs"}}},
+
+      // idkeys writing into the radix buffers, used when the sort runs an odd
+      // number of passes so the sorted result still ends in keys/values
+      {PipelineType::ASSIGN_TILE_IDS_1,
+       {{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "prefixResult"},
+        {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "depths"},
+        {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "visibleIndices"},
+        {3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "boundingBox"},
+        {4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "keysRadix"},
+        {5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "valuesRadix"},
+        {6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "dispatchArgs"},
+        {7, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "conicOpacity"},
+        {8, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "pointsXY"},
+        {9, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "visibleArgs"}}},
+
+      {PipelineType::DEPTH_BUDGET,
+       {{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "prefixResult"},
+        {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "depths"},
+        {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "depthHistogram"},
+        {3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "visibleIndices"},
+        {4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "visibleArgs"}}},
+
+      {PipelineType::DISPATCH_ARGS,
+       {{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "visibleArgs"},
+        {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "dispatchArgs"},
+        {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "depthHistogram"}}},
 
       {PipelineType::RADIX_HISTOGRAM_0,
        {{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
          "keys"},
         {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
-         "histograms"}}},
+         "histograms"},
+        {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "dispatchArgs"}}},
 
       {PipelineType::RADIX_HISTOGRAM_1,
        {{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
          "keysRadix"},
         {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
-         "histograms"}}},
+         "histograms"},
+        {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "dispatchArgs"}}},
 
       {PipelineType::RADIX_SCATTER_0,
        {{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
@@ -218,7 +397,9 @@ private:
         {3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
          "valuesRadix"},
         {4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
-         "histograms"}}},
+         "histograms"},
+        {5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "dispatchArgs"}}},
 
       {PipelineType::RADIX_SCATTER_1,
        {{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
@@ -230,13 +411,17 @@ private:
         {3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
          "values"},
         {4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
-         "histograms"}}},
+         "histograms"},
+        {5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "dispatchArgs"}}},
 
       {PipelineType::TILE_BOUNDARIES,
        {{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
          "keys"},
         {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
-         "ranges"}}},
+         "ranges"},
+        {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
+         "dispatchArgs"}}},
 
       {PipelineType::RENDER,
        {{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1,
@@ -259,13 +444,78 @@ private:
          "finalOutputImage"}}}};
 
   uint32_t _sizeBufferMax = 0;
+
+  // Sort buffer capacity. A resize swaps in new buffers without waiting for
+  // the GPU: each swapchain image rebinds them the next time it records, and
+  // the old set is destroyed once no submitted frame can still read it
+  struct RetiredSortBuffers {
+    std::vector<VkBuffer> buffers;
+    uint64_t generation;
+    uint64_t lastUseFrame; // last submit that bound them
+  };
+  std::vector<RetiredSortBuffers> _retiredSortBuffers;
+  std::vector<uint64_t> _imageSortGeneration; // per swapchain image
+  std::vector<uint64_t> _imageSubmitFrame;    // per swapchain image
+  uint64_t _sortGeneration = 0;
+  uint64_t _frameNumber = 0;
+  uint32_t _sortCapacityCap = UINT32_MAX;
+  uint32_t _sortPeakRequested = 0; // since the last resize
+  int _sortLowUsageFrames = 0;
+  bool _sortCapWarned = false;
   GaussianBuffers _gaussianBuffers;
   BufferManager *_buffManager;
   int32_t _numGaussians;
-  uint32_t _numSteps;
   VkDescriptorSet _radixDescriptorSets[12];
 
-  VkBuffer _resultBufferPrefix;
+  CameraUniforms _cameraUniforms = {};
+
+  // Headless readback, one host buffer per frame slot. 0 = nothing pending
+  StagingRead _readback[frames_in_flight] = {};
+  uint64_t _readbackFrame[frames_in_flight] = {};
+  ReadbackCallback _readbackCallback;
+
+  GpuProfiler _profiler;
+  // Rasterizer of the frame each slot last recorded, for rasterTimeMs
+  RasterizerMode _rasterTimedMode[frames_in_flight] = {};
+  bool _gpuDriven = false;
+
+  // Sort shader specialization: constant_id 0, 1, 2
+  struct {
+    uint32_t minSubgroupSize;
+    uint32_t workgroupSize;
+    uint32_t blocksPerWorkgroup;
+  } _sortSpecData = {};
+  VkSpecializationMapEntry _sortSpecEntries[3] = {};
+  VkSpecializationInfo _sortSpecInfo = {};
+
+  // Preprocess specialization: constant_id 0 = SH_STORAGE, 1, 2 = tile size,
+  // 3 = COV_STORAGE (also read by covariance.comp)
+  struct {
+    uint32_t shStorage;
+    uint32_t tileWidth;
+    uint32_t tileHeight;
+    uint32_t covStorage;
+  } _preprocessSpecData = {};
+  VkSpecializationMapEntry _preprocessSpecEntries[4] = {};
+  VkSpecializationInfo _preprocessSpecInfo = {};
+
+  // Tile size in pixels shared by preprocess, idkeys and render
+  uint32_t _tileWidth = 16;
+  uint32_t _tileHeight = 16;
+  std::string _preprocessShader;
+  // Scale modifier the covariance cache holds, negative until it is built
+  float _covarianceScale = -1.0f;
+
+  // idkeys and render: constant_id 0, 1 = tile size, 2, 3 = workgroup size of
+  // render_shared_mem.comp. Index 1 is the subtile variant
+  struct TileSpecData {
+    uint32_t tileWidth;
+    uint32_t tileHeight;
+    uint32_t groupWidth;
+    uint32_t groupHeight;
+  } _tileSpecData[2] = {};
+  VkSpecializationMapEntry _tileSpecEntries[4] = {};
+  VkSpecializationInfo _tileSpecInfo[2] = {};
 
   struct RenderTarget {
     VkImage image;
@@ -285,6 +535,34 @@ private:
     return *static_cast<uint32_t *>(_gaussianBuffers.numRendered.mem);
   }
 
+  // Every frame copies DispatchArgs::requested into slot 1 + frame,
+  // DispatchArgs::dropped into slot 1 + frames_in_flight + frame and
+  // TileStats into the slots from TileStatsSlot(frame)
+  inline uint32_t ReadRequestedKeys(uint32_t frame) {
+    return static_cast<uint32_t *>(_gaussianBuffers.numRendered.mem)[1 + frame];
+  }
+  inline uint32_t ReadDroppedKeys(uint32_t frame) {
+    return static_cast<uint32_t *>(
+        _gaussianBuffers.numRendered.mem)[1 + frames_in_flight + frame];
+  }
+  static uint32_t TileStatsSlot(uint32_t frame) {
+    return 1 + 2 * frames_in_flight +
+           frame * uint32_t(sizeof(TileStats) / sizeof(uint32_t));
+  }
+  inline TileStats ReadTileStats(uint32_t frame) {
+    auto *slots = static_cast<uint32_t *>(_gaussianBuffers.numRendered.mem);
+    TileStats stats;
+    std::memcpy(&stats, slots + TileStatsSlot(frame), sizeof(TileStats));
+    return stats;
+  }
+
+  // Tile ID and depth fit in a 32-bit key (the shift by depthBits must stay
+  // below 32 as well)
+  inline bool UseKey32() {
+    uint32_t depthBits = uint32_t(g_renderSettings.depthKeyBits);
+    return depthBits < 32 && getTileBits() + depthBits <= 32;
+  }
+
   inline bool IsRadixPipeline(PipelineType pType) {
     return pType == PipelineType::RADIX_HISTOGRAM_0 ||
            pType == PipelineType::RADIX_HISTOGRAM_1 ||
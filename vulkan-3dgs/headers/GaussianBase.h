@@ -3,19 +3,133 @@
 
 #pragma once
 #include "glm/glm.hpp"
+#include <cstdint>
 #include <iostream>
+#include <memory>
 #include <vector>
 
+class MappedFile;
+
+// GPU-ready arrays, in upload order
+enum GaussianArray {
+  GAUSSIAN_POSITIONS, // vec4 xyz1
+  GAUSSIAN_SCALES,    // vec4 exp(scale), 0
+  GAUSSIAN_ROTATIONS, // vec4 normalized quaternion
+  GAUSSIAN_OPACITIES, // float sigmoid(opacity)
+  GAUSSIAN_SH,        // float RGB-interleaved SH coefficients
+  GAUSSIAN_ARRAY_COUNT
+};
+
+// Input layout of preprocess, chosen at build time with -DPACKED_GAUSSIANS=ON
+enum class GaussianLayout {
+  SoA,   // xyz, scales, rotations, opacity in separate buffers
+  Packed // one GaussianRecord buffer
+};
+#ifdef PACKED_GAUSSIAN_LAYOUT
+constexpr GaussianLayout GAUSSIAN_LAYOUT = GaussianLayout::Packed;
+#else
+constexpr GaussianLayout GAUSSIAN_LAYOUT = GaussianLayout::SoA;
+#endif
+
+// 32 bytes, two records per 64-byte cache line. Matches GaussianRecord in
+// preprocess.comp
+struct GaussianRecord {
+  glm::vec4 positionOpacity; // xyz, sigmoid(opacity)
+  glm::uvec4 scaleRotation;  // fp16 pairs: (sx, sy) (sz, qr) (qx, qy) (qz, 0)
+};
+
+// Gaussians per cluster, one preprocess workgroup each
+constexpr uint32_t GAUSSIAN_CLUSTER_SIZE = 256;
+
+// 32 bytes, matches GaussianCluster in cluster_cull.comp. Members are
+// GAUSSIAN_CLUSTER_SIZE consecutive entries of the cluster order; their
+// centers lie within centerRadius and their 3 sigma extents reach at most
+// extent * splat scale further
+struct GaussianCluster {
+  glm::vec4 centerRadius;
+  float extent;
+  uint32_t first; // into the cluster order
+  uint32_t count;
+  uint32_t pad;
+};
+
+// GPU layout of the SH buffer. Matches SH_STORAGE in preprocess.comp; every
+// mode is a packed uint array with a fixed per-Gaussian stride
+enum class SHStorage : uint32_t {
+  Float32,           // 3K floats
+  Half,              // 3K halves, two per uint
+  Quant8,            // float min, float step, 3K bytes
+  DCFloatRestQuant8  // 3 DC floats, float min, float step, 3(K-1) bytes
+};
+// Command line and UI names, indexed by SHStorage
+const char *const SH_STORAGE_NAMES[] = {"fp32", "fp16", "q8", "dc-q8"};
+
+// GPU layout of the 3D covariance cache, see covariance.comp. fp16 keeps
+// the largest variance in fp32 and the matrix divided by it in halves, so
+// precision is relative to the splat's own size
+enum class CovarianceStorage : uint32_t {
+  Float32, // 6 floats
+  Half     // float scale, 6 halves, two per uint
+};
+// Command line and UI names, indexed by CovarianceStorage
+const char *const COV_STORAGE_NAMES[] = {"fp32", "fp16"};
+
+// Per-Gaussian stride in uints for K coefficients per channel
+inline uint32_t SHStorageStride(SHStorage mode, int coeffsPerChannel) {
+  uint32_t values = 3 * uint32_t(coeffsPerChannel);
+  auto bytesToWords = [](uint32_t bytes) { return (bytes + 3) / 4; };
+  switch (mode) {
+  case SHStorage::Half:
+    return (values + 1) / 2;
+  case SHStorage::Quant8:
+    return 2 + bytesToWords(values);
+  case SHStorage::DCFloatRestQuant8:
+    return 5 + bytesToWords(values - 3);
+  default:
+    return values;
+  }
+}
+
 class GaussianBase {
 public:
   GaussianBase(){};
 
   // GPU upload interface
-  const void *GetPositionsData() const { return _xyz.data(); }
-  const void *GetScalesData() const { return _scales.data(); }
-  const void *GetRotationsData() const { return _rotations.data(); }
-  const void *GetOpacitiesData() const { return _opacities.data(); }
-  const void *GetSHData() const { return _shCoefficients.data(); }
+  const void *GetPositionsData() const {
+    return _mapping ? _mappedArrays[GAUSSIAN_POSITIONS] : _xyz.data();
+  }
+  const void *GetScalesData() const {
+    return _mapping ? _mappedArrays[GAUSSIAN_SCALES] : _scales.data();
+  }
+  const void *GetRotationsData() const {
+    return _mapping ? _mappedArrays[GAUSSIAN_ROTATIONS] : _rotations.data();
+  }
+  const void *GetOpacitiesData() const {
+    return _mapping ? _mappedArrays[GAUSSIAN_OPACITIES] : _opacities.data();
+  }
+  const void *GetSHData() const {
+    return _mapping ? _mappedArrays[GAUSSIAN_SH] : _shCoefficients.data();
+  }
+  bool IsMapped() const { return _mapping != nullptr; }
+
+  // Scene from host arrays, one row per Gaussian: xyz, scale xyz, rotation
+  // wxyz, opacity, and coeffsPerChannel RGB SH triplets. Unless activated,
+  // scales and opacities are the raw PLY values (log, logit)
+  static std::unique_ptr<GaussianBase>
+  FromArrays(size_t count, const float *positions, const float *scales,
+             const float *rotations, const float *opacities, const float *sh,
+             int coeffsPerChannel, bool activated);
+
+  // Position, opacity, scale and rotation interleaved for the packed layout
+  std::vector<GaussianRecord> PackRecords() const;
+
+  // SH coefficients in the packed layout of mode, SHStorageStride uints each
+  std::vector<uint32_t> EncodeSH(SHStorage mode) const;
+
+  // Gaussian indices sorted by the Morton code of their position, cut into
+  // clusters of GAUSSIAN_CLUSTER_SIZE. The arrays themselves keep their order
+  void BuildClusters(std::vector<uint32_t> &order,
+                     std::vector<GaussianCluster> &clusters) const;
 
   size_t GetCount() const { return _numGaussians; }
   int GetSHDegree() const { return _shDegree; }
@@ -33,6 +147,11 @@ public:
   std::vector<glm::vec4> _scales;
   std::vector<glm::vec4> _rotations;
 
+  // Scene cache loads point straight into the mapped file instead of filling
+  // the vectors above
+  std::shared_ptr<MappedFile> _mapping;
+  const void *_mappedArrays[GAUSSIAN_ARRAY_COUNT] = {};
+
   size_t _numGaussians = 0;
   int _maxSHDegree = 3;
   int _shDegree = 0;
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
 
 #include "BufferManager.h"
@@ -14,6 +15,9 @@
 #include "RenderSettings.h"
 #include "Sequence.h"
 
+// Upper bound on the host-visible staging memory used by input uploads
+const VkDeviceSize UPLOAD_STAGING_SIZE = 64ull * 1024 * 1024;
+
 class GaussianRenderer {
  public:
   GaussianRenderer(VulkanContext &vulkanContext, int shDegree,
@@ -37,10 +41,28 @@ class GaussianRenderer {
     return _gaussianData ? _gaussianData->GetCount() : 0;
   }
 
+  // Per-stage GPU timings and Chrome trace export
+  const GpuProfiler &GetGpuProfiler() const {
+    return _computePipeline.GetProfiler();
+  }
+
   void InitComputePipeline();
   void CreateBuffers();
   void Render();
 
+  // Headless frames, see ComputePipeline::SetReadbackCallback
+  void SetReadbackCallback(ReadbackCallback callback) {
+    _computePipeline.SetReadbackCallback(std::move(callback));
+  }
+  void FlushReadbacks() { _computePipeline.FlushReadbacks(); }
+  uint64_t GetFrameNumber() const { return _computePipeline.GetFrameNumber(); }
+  bool IsHeadless() const { return _vulkanContext.IsHeadless(); }
+  const VkExtent2D &GetRenderExtent() const {
+    return _vulkanContext.GetSwapchainExtent();
+  }
+  // One frame from explicit uniforms instead of the interactive camera
+  void RenderView(CameraUniforms uniforms);
+
   void InitializeCamera(float windowWidth, float windowHeight);
 
   static void mouse_callback(GLFWwindow *window, double xpos, double ypos);
@@ -57,9 +79,11 @@ class GaussianRenderer {
 
   void CreateGaussianBuffers();
   void CreatePipelineStorageBuffers();
+  // count elements of offset T each, 0 = one per Gaussian
   template <typename T>
   void CreateAndUploadBuffer(VkBuffer &buffer, const void *data,
-                             std::string type, int offset = 1);
+                             std::string type, int offset = 1,
+                             size_t count = 0);
 
   template <typename T>
   void CreateWriteBuffers(VkBuffer &buffer, std::string type, int offset = 1,
@@ -71,37 +95,42 @@ class GaussianRenderer {
   std::shared_ptr<Camera> _camera;
   int _shDegree;
   uint32_t _nGauss;
-  void *_cameraUniformMapped = nullptr;
 };
 
 template <typename T>
 inline void GaussianRenderer::CreateAndUploadBuffer(VkBuffer &buffer,
                                                     const void *data,
                                                     std::string type,
-                                                    int offset) {
+                                                    int offset, size_t count) {
   VkDevice device = _vulkanContext.GetLogicalDevice();
   VkPhysicalDevice physicalDevice = _vulkanContext.GetPhysicalDevice();
 
-  VkDeviceSize bufferSize = _gaussianData->GetCount() * sizeof(T) * offset;
+  if (count == 0)
+    count = _gaussianData->GetCount();
+  VkDeviceSize bufferSize = count * sizeof(T) * offset;
   std::cout << " Creating " << type << " buffer : " << bufferSize << " bytes "
             << std::endl;
   buffer =
       _bufferManager.CreateStorageBuffer(device, physicalDevice, bufferSize);
 
+  // Bounded staging buffer reused across chunks, so a scene cache mapping is
+  // streamed to the GPU without a second full-size host copy
+  VkDeviceSize stagingSize = std::min(bufferSize, UPLOAD_STAGING_SIZE);
   VkBuffer stagingBuffer = _bufferManager.CreateBuffer(
-      device, physicalDevice, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      device, physicalDevice, stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
           VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-  void *mappedMem;
-  VkDeviceMemory deviceMem = _bufferManager.GetBufferMemory(stagingBuffer);
-  vkMapMemory(device, deviceMem, 0, bufferSize, 0, &mappedMem);
-  memcpy(mappedMem, data, static_cast<size_t>(bufferSize));
-  vkUnmapMemory(device, deviceMem);
-
-  _bufferManager.copyBuffer(device, bufferSize, stagingBuffer, buffer,
-                            _vulkanContext.GetCommandPool(),
-                            _vulkanContext.GetGraphicsQueue());
+  void *mappedMem = _bufferManager.MapBuffer(stagingBuffer);
+  for (VkDeviceSize uploaded = 0; uploaded < bufferSize;
+       uploaded += stagingSize) {
+    VkDeviceSize chunk = std::min(stagingSize, bufferSize - uploaded);
+    memcpy(mappedMem, static_cast<const char *>(data) + uploaded,
+           static_cast<size_t>(chunk));
+    _bufferManager.copyBuffer(device, chunk, stagingBuffer, buffer,
+                              _vulkanContext.GetCommandPool(),
+                              _vulkanContext.GetGraphicsQueue(), 0, uploaded);
+  }
 
   _bufferManager.DestroyBuffer(device, stagingBuffer);
 
@@ -118,7 +147,8 @@ inline void GaussianRenderer::CreateWriteBuffers(VkBuffer &buffer,
   VkPhysicalDevice physicalDevice = _vulkanContext.GetPhysicalDevice();
   VkDevice device = _vulkanContext.GetLogicalDevice();
   VkBufferUsageFlags usage = (dst) ? VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
-                                         VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                                         VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                         VK_BUFFER_USAGE_TRANSFER_DST_BIT
                                    : VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
   buffer =
       _bufferManager.CreateBuffer(device, physicalDevice, bufferSize, usage,
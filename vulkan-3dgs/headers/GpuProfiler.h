@@ -0,0 +1,86 @@
+// Vulkan 3DGS - Copyright (c) 2025 Alejandro Amat (github.com/AlejandroAmat) -
+// MIT Licensed
+
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+// Timestamp pairs around named dispatch groups. Every frame slot owns its own
+// range of queries, recycled by the first command buffer of the frame and
+// read back after that slot's fence wait, so collecting never stalls
+class GpuProfiler {
+ public:
+  static const uint32_t MAX_STAGES = 32;     // per frame
+  static const uint32_t HISTORY = 240;       // samples kept per stage
+  static const uint32_t TRACE_FRAMES = 600;  // frames kept for export
+
+  struct StageStats {
+    std::string name;
+    float lastMs = 0.0f;
+    float minMs = 0.0f;
+    float avgMs = 0.0f;
+    float p99Ms = 0.0f;
+    uint32_t samples = 0;
+  };
+
+  void Init(VkPhysicalDevice physicalDevice, VkDevice device,
+            uint32_t queueFamily, uint32_t frameSlots);
+  void CleanUp();
+  bool IsSupported() const { return _queryPool != VK_NULL_HANDLE; }
+
+  // Recording. BeginFrame goes in the first command buffer of the slot,
+  // stages follow in submission order and do not nest
+  void BeginFrame(VkCommandBuffer commandBuffer, uint32_t slot);
+  void BeginStage(VkCommandBuffer commandBuffer, const char *name);
+  void EndStage(VkCommandBuffer commandBuffer);
+
+  // After the fence of slot signalled. False if it recorded nothing
+  bool Collect(uint32_t slot);
+
+  // Rolling statistics per stage, in recording order
+  std::vector<StageStats> GetStats() const;
+  // Stage time in the last collected frame, negative if it did not run
+  float LastStageMs(const std::string &name) const;
+  void ResetStats();
+
+  // Chrome trace (chrome://tracing, Perfetto) of the retained frames
+  bool ExportChromeTrace(const std::string &path) const;
+
+ private:
+  struct PendingStage {
+    std::string name;
+    uint32_t query; // begin, end is query + 1
+  };
+  struct SlotState {
+    std::vector<PendingStage> stages;
+    uint32_t nextQuery = 0;
+    bool open = false; // a stage began and has not ended
+  };
+  struct TraceEvent {
+    std::string name;
+    double beginUs;
+    double endUs;
+  };
+  struct TraceFrame {
+    uint64_t frame;
+    std::vector<TraceEvent> events;
+  };
+
+  VkDevice _device = VK_NULL_HANDLE;
+  VkQueryPool _queryPool = VK_NULL_HANDLE;
+  double _nsPerTick = 0.0;
+  uint64_t _validMask = 0;
+  std::vector<SlotState> _slots;
+  uint32_t _recordingSlot = 0;
+
+  std::vector<std::string> _stageOrder;
+  std::map<std::string, std::deque<float>> _history;
+  std::map<std::string, float> _lastFrame;
+  std::deque<TraceFrame> _trace;
+  uint64_t _collectedFrames = 0;
+};
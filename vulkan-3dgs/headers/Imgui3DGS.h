@@ -2,8 +2,10 @@
 
 #include <vulkan/vulkan.h>
 //
+#include "BufferManager.h"
 #include "Camera.h"
 #include "GPUMemInfo.h"
+#include "GpuProfiler.h"
 #include "RenderSettings.h"
 #include "Sequence.h"
 #include "VulkanContext.h"
@@ -22,6 +24,10 @@ public:
   void RecordImGuiRenderPass(VkCommandBuffer commandBuffer,
                              uint32_t imageIndex);
   void CreateUI(Camera &cam);
+  void setBufferManager(BufferManager *bufferManager) {
+    _bufferManager = bufferManager;
+  }
+  void setProfiler(const GpuProfiler *profiler) { _profiler = profiler; }
 
 private:
   VulkanContext &_vkContext;
@@ -30,6 +36,8 @@ private:
   std::vector<VkFramebuffer> _frameBuffers;
   std::vector<VkCommandBuffer> _commandBuffers;
   Sequence &_seqRecorder;
+  BufferManager *_bufferManager = nullptr;
+  const GpuProfiler *_profiler = nullptr;
 
   void CreateRenderPass();
   void CreateFrameBuffers();
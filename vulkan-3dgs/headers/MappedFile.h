@@ -0,0 +1,30 @@
+// Vulkan 3DGS - Copyright (c) 2025 Alejandro Amat (github.com/AlejandroAmat) -
+// MIT Licensed
+
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Read-only mapping of a whole file, unmapped on destruction. data() is null
+// when the file could not be opened or mapped
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const char *data() const { return _data; }
+  size_t size() const { return _size; }
+
+private:
+  const char *_data = nullptr;
+  size_t _size = 0;
+#ifdef _WIN32
+  void *_file = nullptr; // HANDLE
+  void *_mapping = nullptr;
+#else
+  int _fd = -1;
+#endif
+};
@@ -9,12 +9,64 @@
 #include <string>
 
 #include "GaussianBase.h"
+
+enum class PLYReadMode {
+  Stream, // std::ifstream, records read in chunks
+  Mapped  // memory mapped file, records decoded in parallel chunks
+};
+
+enum class PLYFormat { BinaryLittleEndian, BinaryBigEndian, Ascii };
+
+// Decoded record: x y z, nx ny nz, f_dc_0..2, f_rest_0..44, opacity,
+// scale_0..2, rot_0..3. Fixed slots whatever the file order or SH degree
+const uint32_t PLY_SLOT_REST = 9;
+const uint32_t PLY_SLOT_OPACITY = 54;
+const uint32_t PLY_SLOT_SCALE = 55;
+const uint32_t PLY_SLOT_ROT = 58;
+const uint32_t PLY_RECORD_FLOATS = 62;
+
+// Vertex layout of one file, resolved from the header once. Decoding a
+// record is a walk over the gather tables with no per-record layout checks
+struct PLYSchema {
+  PLYFormat format = PLYFormat::BinaryLittleEndian;
+  size_t numVertices = 0;
+  size_t vertexOffset = 0;  // binary: bytes of elements before the vertices
+  size_t linesBefore = 0;   // ascii: lines of elements before the vertices
+  size_t stride = 0;        // binary: bytes per vertex record
+  size_t numProperties = 0; // ascii: values per vertex line
+  int shDegree = 0;
+
+  struct Gather {
+    size_t srcOffset;  // byte offset in a binary record
+    uint32_t srcIndex; // property index in an ascii line
+    uint32_t slot;     // destination slot in the decoded record
+    float (*read)(const char *); // typed, byte swapping reader
+  };
+  std::vector<Gather> copyGathers;    // little endian float32: plain copies
+  std::vector<Gather> convertGathers; // any other type or byte order
+  float defaults[PLY_RECORD_FLOATS] = {};
+};
+
 class PLYLoader {
  public:
-  static std::unique_ptr<GaussianBase> LoadPLY(const std::string &path,
-                                               int &max_sh_degree);
+  static std::unique_ptr<GaussianBase> LoadPLY(
+      const std::string &path, int &max_sh_degree,
+      PLYReadMode mode = PLYReadMode::Mapped);
 
  private:
-  static bool ParseHeader(std::ifstream &file, GaussianBase &data);
-  static bool ReadVertexData(std::ifstream &file, GaussianBase &data);
+  static bool ParseHeader(std::istream &file, PLYSchema &schema);
+  static bool ReadVertexData(std::ifstream &file, const PLYSchema &schema,
+                             GaussianBase &data);
+  static bool ReadVertexDataMapped(const char *body, size_t size,
+                                   const PLYSchema &schema,
+                                   GaussianBase &data);
+  static bool ReadVertexDataAscii(const char *text, size_t size,
+                                  const PLYSchema &schema, GaussianBase &data);
+  static void AllocateData(const PLYSchema &schema, GaussianBase &data);
+  // block holds the binary records [first, last)
+  static void DecodeRecords(const char *block, size_t first, size_t last,
+                            const PLYSchema &schema, GaussianBase &data);
+  static void StoreRecord(const float *record, size_t i, int shDegree,
+                          GaussianBase &data);
+  static void ApplyActivations(size_t first, size_t last, GaussianBase &data);
 };
@@ -1,12 +1,37 @@
 #pragma once
+#include "GaussianBase.h"
 #include "glm/glm.hpp"
 #include "string"
 
+// RENDER pass variant, see render.comp and render_shared_mem.comp
+enum class RasterizerMode : uint32_t {
+  Global,       // every pixel reads its tile's Gaussians from global memory
+  Shared,       // one workgroup per tile, Gaussians staged in shared memory
+  SharedSubtile // four workgroups of half the tile size per tile
+};
+const char *const RASTERIZER_NAMES[] = {"global", "shared", "shared subtiles"};
+
+// Tile sizes offered in the UI. The ranges buffer is sized for
+// MIN_TILE_DIM x MIN_TILE_DIM tiles, so no tile may be smaller
+const uint32_t MIN_TILE_DIM = 8;
+const int TILE_SIZE_PRESETS[][2] = {
+    {8, 8}, {16, 8}, {16, 16}, {32, 8}, {32, 16}};
+const char *const TILE_SIZE_NAMES[] = {"8x8", "16x8", "16x16", "32x8", "32x16"};
+
 struct RenderSettings {
 
   // Display
   uint32_t numGaussians;
   int numRendered;
+  int numDropped = 0; // keys cut by the splat budget, one frame late
+  float keysPerGaussian = 0.0f;     // per visible Gaussian, one frame late
+  float aabbKeysPerGaussian = 0.0f; // same without the exact tile test
+  int shDegreeGaussians[4] = {};    // shaded at each SH degree, same
+  uint32_t numClusters = 0;
+  int visibleClusters = 0;  // kept by the cluster cull, same
+  int clusterGaussians = 0; // Gaussians preprocess ran for, same
+  // GPU time of the RENDER dispatch per rasterizer, smoothed; 0 = not run yet
+  float rasterTimeMs[3] = {0.0f, 0.0f, 0.0f};
   int width;
   int height;
   glm::vec3 pos;
@@ -18,9 +43,33 @@ struct RenderSettings {
   float nearPlane = 0.1f;
   float farPlane = 1000.0f;
   bool enableCulling = true;
-  int tileSize = 16;
-  float gaussianScale = 1.0f;
+  bool clusterCulling = true; // skip preprocess for clusters out of view
+  int tileWidth = 16; // pixels, tile-keyed pipelines are rebuilt on change
+  int tileHeight = 16;
+  bool exactTileTest = true; // ellipse vs tile instead of the circle's box
+  bool opacityAwareRadius = false; // extent where alpha reaches 1/255
+  // SH level of detail: below shLodRadius pixels only the base color, one
+  // more band per doubling. Past shLodDistance (0 = off) the base color only
+  bool shLod = false;
+  float shLodRadius = 4.0f;
+  float shLodDistance = 0.0f;
+  float gaussianScale = 1.0f; // wireframe ring radius in sigmas
+  float splatScale = 1.0f;    // scales every Gaussian, rebuilds the cache
   bool showWireframe = false;
+  RasterizerMode rasterizer = RasterizerMode::Shared;
+  bool gpuDrivenFrame = false;
+  int depthKeyBits = 32; // 32 = exact float depth, 16/20 = quantized
+  SHStorage shStorage = SHStorage::Float32; // fixed once the scene is loaded
+  CovarianceStorage covStorage = CovarianceStorage::Float32; // same
+  // Sort buffers grow to requested * factor, shrink after that many frames
+  // well below capacity, and never take more than the fraction of VRAM
+  float sortGrowthFactor = 1.5f;
+  int sortShrinkFrames = 300;
+  float sortMemoryFraction = 0.5f;
+  // Opt-in: the onesweep lookback waits on earlier workgroups and counts a
+  // stalled one's keys itself after a bounded spin, so it is safe without
+  // forward progress but slower where it stalls (Intel, lavapipe, mobile)
+  bool onesweepSort = false;
 
   float exposure = 1.0f;
   float gamma = 2.2f;
@@ -0,0 +1,48 @@
+// Vulkan 3DGS - Copyright (c) 2025 Alejandro Amat (github.com/AlejandroAmat) -
+// MIT Licensed
+
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "GaussianBase.h"
+
+// .3dgsbin: post-activation Gaussians in the exact GPU buffer layouts, so a
+// load is one mmap and the upload reads straight from the mapping.
+//   SceneCacheHeader | pad | positions | pad | scales | ... | sh
+// Every array starts at a SCENE_CACHE_ALIGNMENT boundary
+const char SCENE_CACHE_MAGIC[8] = {'3', 'D', 'G', 'S', 'B', 'I', 'N', '\0'};
+const uint32_t SCENE_CACHE_VERSION = 1;
+const uint64_t SCENE_CACHE_ALIGNMENT = 4096;
+
+struct SceneCacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t shDegree;
+  uint64_t numGaussians;
+  // PLY the cache was built from, a mismatch means the cache is stale
+  uint64_t sourceSize;
+  int64_t sourceModified;
+  struct {
+    uint64_t offset;
+    uint64_t size;
+  } arrays[GAUSSIAN_ARRAY_COUNT];
+};
+
+class SceneCache {
+ public:
+  static bool IsCacheFile(const std::string &path);
+  // scene.ply -> scene.3dgsbin
+  static std::string CachePathFor(const std::string &plyPath);
+
+  // sourcePath may be empty to skip the staleness check
+  static std::unique_ptr<GaussianBase> Load(const std::string &cachePath,
+                                            const std::string &sourcePath);
+  static bool Write(const std::string &cachePath,
+                    const std::string &sourcePath, const GaussianBase &data);
+
+ private:
+  static bool SourceStamp(const std::string &sourcePath, uint64_t &size,
+                          int64_t &modified);
+};
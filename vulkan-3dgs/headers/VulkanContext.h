@@ -20,6 +20,11 @@ const bool enableValidationLayers = true;
 class VulkanContext {
  public:
   VulkanContext(GLFWwindow *newWindow) : _vcxWindow(newWindow){};
+  // Headless: no window, surface or swapchain. The renderer writes into
+  // imageCount offscreen storage images of the given extent instead
+  VulkanContext(VkExtent2D extent, uint32_t imageCount)
+      : _vcxWindow(nullptr), _vcxOffscreenImageCount(imageCount),
+        _vcxSwapChainExtent2D(extent){};
 
   int InitContext();
 
@@ -44,16 +49,20 @@ class VulkanContext {
   int32_t SwapchainSize() const { return (int32_t)_vcxImages.size(); }
 
   VkCommandPool GetCommandPool() const { return _vcxCommandPool; }
+  uint32_t GetSubgroupSize() const { return _vcxSubgroupSize; }
+  // Narrowest subgroup a dispatch may get, at most GetSubgroupSize()
+  uint32_t GetMinSubgroupSize() const { return _vcxMinSubgroupSize; }
 
   ~VulkanContext();
 
   GLFWwindow *getWindow() const { return _vcxWindow; }
+  bool IsHeadless() const { return _vcxWindow == nullptr; }
 
  private:
   GLFWwindow *_vcxWindow;
   VkInstance _vcxInstance;
 
-  VkSurfaceKHR _vcxSurface;
+  VkSurfaceKHR _vcxSurface = VK_NULL_HANDLE;
 
   struct {
     VkPhysicalDevice physicalDevice;
@@ -63,17 +72,24 @@ class VulkanContext {
   VkQueue _vcxGraphicsQueue;
   VkQueue _vcxPresentationQueue;
 
-  VkSwapchainKHR _vcxSwapchain;
+  VkSwapchainKHR _vcxSwapchain = VK_NULL_HANDLE;
   std::vector<SwapChainImage> _vcxImages;
+  // Headless only, backing memory of _vcxImages
+  std::vector<VkDeviceMemory> _vcxOffscreenMemory;
+  uint32_t _vcxOffscreenImageCount = 0;
 
   VkFormat _vcxSwapChainFormat;
   VkExtent2D _vcxSwapChainExtent2D;
 
   VkCommandPool _vcxCommandPool;
 
+  uint32_t _vcxSubgroupSize = 32;
+  uint32_t _vcxMinSubgroupSize = 1;
+
   // get Functions
   void GetPhysicalDeviceInternal();
   QueueFamilyIndices GetQueueFamilies(VkPhysicalDevice device);
+  static bool HasDeviceExtension(VkPhysicalDevice device, const char *name);
   SwapChainDetails GetSwapChainDetails(VkPhysicalDevice device);
 
   // create Functions
@@ -81,6 +97,7 @@ class VulkanContext {
   void CreateSurface();
   void CreateLogicalDevice();
   void CreateSwapChain();
+  void CreateOffscreenImages();
   void CreateCommandPool();
 
   // support
@@ -91,6 +108,10 @@ class VulkanContext {
       VkPhysicalDevice device);  // swapchain compatibility is checked on
                                  // physical device level
   bool CheckValidationLayerSupport();
+  // Swapchain extension unless headless
+  std::vector<const char *> RequiredDeviceExtensions() const;
+  uint32_t FindMemoryType(uint32_t typeFilter,
+                          VkMemoryPropertyFlags properties);
 
   // choose for Swapchain
   VkSurfaceFormatKHR ChooseBestFormatSurface(
@@ -23,7 +23,7 @@ public:
   ~WindowManager() { DestroyWindow(); }
 
 private:
-  GLFWwindow *_window;
+  GLFWwindow *_window = nullptr; // never created headless
   const int _w, _h;
   const std::string _wName;
 };
@@ -1,9 +1,40 @@
 #pragma once
 #include "string"
+#include <memory>
 #include <optional>
 #include "RenderSettings.h"
+#include "BatchRenderer.h"
+#include "Sequence.h"
+#include "VulkanContext.h"
 
 void renderGaussians(const std::string path,
                      const std::string& shaderDir,
                      std::optional<uint32_t> width = std::nullopt,
-                     std::optional<uint32_t> height = std::nullopt);
\ No newline at end of file
+                     std::optional<uint32_t> height = std::nullopt);
+
+// Headless renderer owned by the caller instead of an event loop. The scene
+// is uploaded once, each Render returns the image in the mapped readback
+// memory of its frame slot, which the frame frames_in_flight renders later
+// overwrites. Render settings are global, so one instance at a time
+class SceneRenderer {
+ public:
+  SceneRenderer(std::unique_ptr<GaussianBase> scene,
+                const std::string &shaderDir, uint32_t width,
+                uint32_t height);
+
+  // view: world to camera, x right, y down, z forward (COLMAP / OpenCV)
+  // intrinsics: pinhole K in pixels
+  const ReadbackFrame &Render(const glm::mat4 &view,
+                              const glm::mat3 &intrinsics);
+
+  uint32_t GetWidth() const { return _width; }
+  uint32_t GetHeight() const { return _height; }
+  size_t GetGaussianCount() const { return _renderer->GetGaussianCount(); }
+
+ private:
+  uint32_t _width, _height;
+  Sequence _sequence;
+  std::optional<VulkanContext> _context;
+  std::optional<GaussianRenderer> _renderer;
+  ReadbackFrame _last = {};
+};
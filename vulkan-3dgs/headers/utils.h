@@ -6,6 +6,7 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
@@ -14,6 +15,8 @@
 #include <set>
 #include <vector>
 
+#include "GaussianBase.h"
+
 struct StagingRead {
   VkBuffer staging;
   void *mem;
@@ -46,14 +49,70 @@ struct InputArgs {
   std::string ply;
   int w;
   int h;
+  SHStorage shStorage = SHStorage::Float32;
+  CovarianceStorage covStorage = CovarianceStorage::Float32;
+  // Offscreen rendering without a window, frames written as <output>_N.ppm
+  bool headless = false;
+  int frames = 1;
+  std::string output = "frame";
+  // COLMAP text model, every view rendered into the <output> directory
+  std::string batch;
 };
 constexpr int AVG_GAUSS_TILE = 4;
+// Sort keys allocated per Gaussian before the first resize
+constexpr int INITIAL_KEYS_PER_GAUSSIAN = 10;
+
+// Written by dispatch_args.comp after the prefix sum. Layout must match the
+// DispatchArgs block in the shaders.
+struct DispatchArgs {
+  uint32_t numRendered; // keys emitted this frame (within capacity)
+  uint32_t requested;   // keys the prefix sum asked for
+  uint32_t sortWorkgroups;
+  uint32_t dropped; // keys cut by the splat budget
+  VkDispatchIndirectCommand sortDispatch;
+  uint32_t pad1;
+  VkDispatchIndirectCommand boundariesDispatch;
+  uint32_t pad2;
+  uint32_t depthCutoff; // first dropped depth bucket, none if == BUCKETS
+  uint32_t keyCursor;   // idkeys write cursor when over budget
+};
+
+// Written by preprocess.comp, cleared every frame. Keys per visible Gaussian
+// with and without the exact ellipse/tile test, the SH level of detail, and
+// what the cluster cull let through
+struct TileStats {
+  uint32_t visibleGaussians;
+  uint32_t aabbKeys; // keys the bounding boxes alone would emit
+  uint32_t shDegreeGaussians[4]; // Gaussians shaded at each SH degree
+  uint32_t visibleClusters;  // written by cluster_cull.comp
+  uint32_t clusterGaussians; // Gaussians preprocess ran for
+};
+
+// Compacted visible set, reset every frame. cluster_cull.comp counts the
+// preprocess workgroups, preprocess.comp appends the Gaussians that touch a
+// tile and grows the dispatch sizes, the prefix sum adds the key total.
+// Layout must match the VisibleArgs block in the shaders
+struct VisibleArgs {
+  uint32_t visibleCount;
+  uint32_t totalTiles; // keys requested this frame
+  uint32_t pad0[2];
+  VkDispatchIndirectCommand visibleDispatch; // 256 visible per workgroup
+  uint32_t pad1;
+  VkDispatchIndirectCommand prefixDispatch; // PREFIX_SUM_BLOCK_SIZE each
+  uint32_t pad2;
+  VkDispatchIndirectCommand preprocessDispatch; // one per visible cluster
+  uint32_t pad3;
+};
+
+// Log depth buckets of the splat budget, see depth_budget.comp
+constexpr uint32_t DEPTH_BUDGET_BUCKETS = 1024;
 
 struct GaussianBuffers {
   VkBuffer xyz;
   VkBuffer scales;
   VkBuffer rotations;
   VkBuffer opacity;
+  VkBuffer records; // GaussianLayout::Packed, replaces the four above
   VkBuffer sh;
   VkBuffer camUniform;
   VkBuffer radii;
@@ -63,6 +122,7 @@ struct GaussianBuffers {
   VkBuffer points2d;
   VkBuffer tilesTouched;
   VkBuffer tilesTouchedPrefixSum;
+  VkBuffer prefixBlockSums;
   VkBuffer boundingBox;
   StagingRead numRendered;
   VkBuffer keys;
@@ -71,6 +131,15 @@ struct GaussianBuffers {
   VkBuffer values;
   VkBuffer ranges;
   VkBuffer histogram;
+  VkBuffer dispatchArgs;
+  VkBuffer depthHistogram; // DEPTH_BUDGET_BUCKETS tile counts
+  VkBuffer tileStats;
+  VkBuffer visibleIndices; // Gaussian of each visible slot
+  VkBuffer visibleArgs;
+  VkBuffer covariance3D; // CovarianceStorage, built by covariance.comp
+  VkBuffer clusters;        // GaussianCluster, built at load
+  VkBuffer clusterOrder;    // Gaussian indices in Morton order
+  VkBuffer visibleClusters; // written by cluster_cull.comp
 };
 
 const std::vector<const char *> deviceExtensions = {
@@ -114,15 +183,63 @@ static std::vector<char> ReadFile(const std::string &filename) {
 }
 
 static std::optional<InputArgs> checkArgs(int argc, char *argv[]) {
-  if (argc != 2 && argc != 4) {
+  // Options first, what remains is <pointcloud_file> (<width> <height>)
+  SHStorage shStorage = SHStorage::Float32;
+  CovarianceStorage covStorage = CovarianceStorage::Float32;
+  bool headless = false;
+  int frames = 1;
+  std::string output = "frame";
+  std::string batch;
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--sh-storage" && i + 1 < argc) {
+      std::string name = argv[++i];
+      auto match = std::find(std::begin(SH_STORAGE_NAMES),
+                             std::end(SH_STORAGE_NAMES), name);
+      if (match == std::end(SH_STORAGE_NAMES)) {
+        std::cerr << "Error: Unknown SH storage '" << name
+                  << "' (fp32, fp16, q8, dc-q8)" << std::endl;
+        return std::nullopt;
+      }
+      shStorage = SHStorage(match - std::begin(SH_STORAGE_NAMES));
+    } else if (arg == "--cov-storage" && i + 1 < argc) {
+      std::string name = argv[++i];
+      auto match = std::find(std::begin(COV_STORAGE_NAMES),
+                             std::end(COV_STORAGE_NAMES), name);
+      if (match == std::end(COV_STORAGE_NAMES)) {
+        std::cerr << "Error: Unknown covariance storage '" << name
+                  << "' (fp32, fp16)" << std::endl;
+        return std::nullopt;
+      }
+      covStorage = CovarianceStorage(match - std::begin(COV_STORAGE_NAMES));
+    } else if (arg == "--headless") {
+      headless = true;
+    } else if (arg == "--frames" && i + 1 < argc) {
+      frames = std::max(1, atoi(argv[++i]));
+    } else if (arg == "--output" && i + 1 < argc) {
+      output = argv[++i];
+    } else if (arg == "--batch" && i + 1 < argc) {
+      batch = argv[++i];
+      headless = true;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+
+  if (positional.size() != 1 && positional.size() != 3) {
     std::cerr << "Usage: " << argv[0]
-              << " <pointcloud_file> (<width> <height>)-optional-" << std::endl;
+              << " <pointcloud_file> (<width> <height>)-optional-"
+              << " [--sh-storage fp32|fp16|q8|dc-q8]"
+              << " [--cov-storage fp32|fp16]"
+              << " [--headless [--frames N] [--output prefix]]"
+              << " [--batch colmap_model [--output dir]]" << std::endl;
     std::cerr << "Example: " << argv[0] << " data/scene.ply 1200 800"
               << std::endl;
     return std::nullopt;
   }
 
-  std::string pointcloudPath = argv[1];
+  std::string pointcloudPath = positional[0];
 
   if (!std::filesystem::exists(pointcloudPath)) {
     std::cerr << "Error: File '" << pointcloudPath << "' does not exist!"
@@ -132,15 +249,18 @@ static std::optional<InputArgs> checkArgs(int argc, char *argv[]) {
   int w = 1200;
   int h = 800;
 
-  if (argc > 2) {
-    w = atoi(argv[2]);
-    h = atoi(argv[3]);
+  if (positional.size() > 1) {
+    w = atoi(positional[1].c_str());
+    h = atoi(positional[2].c_str());
     if (w < 500 && w > 3200 && h < 400 && h > 2500) {
       std::cerr << "Error: Width & Hight dimensions exceed the expected range"
                 << std::endl;
       return std::nullopt;
     }
+  } else if (!batch.empty()) {
+    w = h = 0; // size of the first view
   }
 
-  return InputArgs{pointcloudPath, w, h};
+  return InputArgs{pointcloudPath, w, h, shStorage, covStorage, headless,
+                   frames, output, batch};
 }
\ No newline at end of file
@@ -5,17 +5,39 @@
 
 void Application::Start() {
 
-  _gaussianData = PLYLoader::LoadPLY(_pointCloudFile, _degree);
-  _windowManager.InitWindow();
-  int width, height;
-  glfwGetFramebufferSize(_windowManager.getWindow(), &width, &height);
-
-  _vkContext.emplace(_windowManager.getWindow());
-  _vkContext->InitContext();
+  _gaussianData = LoadScene(_pointCloudFile);
+  if (!_gaussianData)
+    throw std::runtime_error("Failed to load " + _pointCloudFile);
+  _degree = _gaussianData->GetSHDegree();
+  if (!_batchModel.empty()) {
+    _batchViews = BatchRenderer::LoadColmapViews(_batchModel);
+    if (_batchViews.empty())
+      throw std::runtime_error("No views in " + _batchModel);
+    if (_width == 0) {
+      _width = int(_batchViews[0].width);
+      _height = int(_batchViews[0].height);
+    }
+  }
+  int width = _width, height = _height;
+  if (_headless) {
+    // Offscreen images cycle with the frame slots
+    g_renderSettings.width = width;
+    g_renderSettings.height = height;
+    _vkContext.emplace(VkExtent2D{uint32_t(width), uint32_t(height)},
+                       uint32_t(frames_in_flight));
+  } else {
+    _windowManager.InitWindow();
+    glfwGetFramebufferSize(_windowManager.getWindow(), &width, &height);
+    _vkContext.emplace(_windowManager.getWindow());
+  }
+  if (_vkContext->InitContext() != 0)
+    throw std::runtime_error("Failed to initialize the Vulkan context");
 
 #ifdef __APPLE__
-  width /= 2;
-  height /= 2;
+  if (!_headless) {
+    width /= 2;
+    height /= 2;
+  }
 #endif
 
   std::cout << width << height << std::endl;
@@ -27,13 +49,101 @@ void Application::Start() {
   _renderPipeline->CreateBuffers();
   _renderPipeline->InitComputePipeline();
 
+  if (_headless && _batchViews.empty()) {
+    _renderPipeline->SetReadbackCallback([this](const ReadbackFrame &frame) {
+      std::string path =
+          _outputPrefix + "_" + std::to_string(frame.frame) + ".ppm";
+      if (WriteImage(path, frame))
+        std::cout << "Wrote " << path << std::endl;
+    });
+  }
+  if (_headless)
+    return;
   glfwSetInputMode(_windowManager.getWindow(), GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 }
 
+bool Application::WriteImage(const std::string &path,
+                             const ReadbackFrame &frame) {
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    std::cerr << "Cannot write " << path << std::endl;
+    return false;
+  }
+  file << "P6\n" << frame.width << " " << frame.height << "\n255\n";
+  std::vector<uint8_t> row(size_t(frame.width) * 3);
+  for (uint32_t y = 0; y < frame.height; y++) {
+    const uint8_t *src = frame.rgba + size_t(y) * frame.width * 4;
+    for (uint32_t x = 0; x < frame.width; x++) {
+      row[x * 3 + 0] = src[x * 4 + 0];
+      row[x * 3 + 1] = src[x * 4 + 1];
+      row[x * 3 + 2] = src[x * 4 + 2];
+    }
+    file.write(reinterpret_cast<const char *>(row.data()), row.size());
+  }
+  return bool(file);
+}
+
+void Application::RenderBatch() {
+  std::filesystem::create_directories(_outputPrefix);
+  BatchRenderer batch(*_renderPipeline);
+  BatchStats stats = batch.Run(
+      _batchViews, [this](size_t, const BatchView &view,
+                          const ReadbackFrame &frame) {
+        std::filesystem::path path =
+            std::filesystem::path(_outputPrefix) / view.name;
+        path.replace_extension(".ppm");
+        std::filesystem::create_directories(path.parent_path());
+        WriteImage(path.string(), frame);
+      });
+
+  std::cout << "Rendered " << stats.views << " views (" << stats.frames
+            << " frames) in " << stats.seconds << " s, "
+            << double(stats.views) / std::max(stats.seconds, 1e-9)
+            << " views/s" << std::endl;
+  if (stats.incomplete > 0)
+    std::cout << " " << stats.incomplete
+              << " views exceeded the sort memory cap and are incomplete"
+              << std::endl;
+}
+
+std::unique_ptr<GaussianBase> Application::LoadScene(const std::string &path) {
+  if (SceneCache::IsCacheFile(path))
+    return SceneCache::Load(path, "");
+
+  // The cache next to the PLY is rebuilt whenever the PLY changes
+  std::string cachePath = SceneCache::CachePathFor(path);
+  if (std::filesystem::exists(cachePath)) {
+    if (auto cached = SceneCache::Load(cachePath, path))
+      return cached;
+  }
+
+  int degree = 0;
+  auto data = PLYLoader::LoadPLY(path, degree);
+  if (data)
+    SceneCache::Write(cachePath, path, *data);
+  return data;
+}
+
 void Application::Render() {
 
   _frameTimer.UpdateTime();
   //_frameTimer.PrintStats();
+
+  if (!_batchViews.empty()) {
+    RenderBatch();
+    _framesLeft = 0;
+    return;
+  }
+
+  // Frames are read back asynchronously, the last ones once all are queued
+  if (_headless) {
+    _renderPipeline->UpdateCameraUniforms();
+    _renderPipeline->Render();
+    if (--_framesLeft == 0)
+      _renderPipeline->FlushReadbacks();
+    return;
+  }
+
   glfwPollEvents();
 
   _renderPipeline->processInput(static_cast<float>(_frameTimer.deltaTime));
@@ -1,2 +1,196 @@
 // Vulkan 3DGS - Copyright (c) 2024 Alejandro Amat (github.com/AlejandroAmat) - MIT Licensed
 
+#include "GaussianBase.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "glm/gtc/packing.hpp"
+
+namespace {
+
+// Bytes of the quantized values, four per uint starting at the low byte
+void PackQuant8(const float *values, uint32_t count, float minValue,
+                float step, uint32_t *out) {
+  float invStep = step > 0.0f ? 1.0f / step : 0.0f;
+  for (uint32_t i = 0; i < count; ++i) {
+    float q = std::round((values[i] - minValue) * invStep);
+    uint32_t byte = uint32_t(std::clamp(q, 0.0f, 255.0f));
+    out[i / 4] |= byte << (8 * (i % 4));
+  }
+}
+
+// Writes min and step, then the bytes, per-Gaussian range of values
+void EncodeQuant8(const float *values, uint32_t count, uint32_t *out) {
+  float minValue = 0.0f, maxValue = 0.0f;
+  if (count > 0) {
+    auto range = std::minmax_element(values, values + count);
+    minValue = *range.first;
+    maxValue = *range.second;
+  }
+  float step = (maxValue - minValue) / 255.0f;
+  std::memcpy(&out[0], &minValue, sizeof(float));
+  std::memcpy(&out[1], &step, sizeof(float));
+  PackQuant8(values, count, minValue, step, out + 2);
+}
+
+// 10 bits spread to every third bit
+uint32_t SpreadBits(uint32_t v) {
+  v = (v | (v << 16)) & 0x030000FF;
+  v = (v | (v << 8)) & 0x0300F00F;
+  v = (v | (v << 4)) & 0x030C30C3;
+  v = (v | (v << 2)) & 0x09249249;
+  return v;
+}
+
+} // namespace
+
+std::unique_ptr<GaussianBase>
+GaussianBase::FromArrays(size_t count, const float *positions,
+                         const float *scales, const float *rotations,
+                         const float *opacities, const float *sh,
+                         int coeffsPerChannel, bool activated) {
+  int degree = int(std::lround(std::sqrt(float(coeffsPerChannel)))) - 1;
+  if (degree < 0 || degree > 3 ||
+      (degree + 1) * (degree + 1) != coeffsPerChannel)
+    throw std::runtime_error("SH needs 1, 4, 9 or 16 coefficients per channel");
+
+  auto data = std::make_unique<GaussianBase>();
+  data->_numGaussians = count;
+  data->_shDegree = degree;
+  data->_xyz.resize(count);
+  data->_normals.resize(count);
+  data->_opacities.assign(opacities, opacities + count);
+  data->_scales.resize(count);
+  data->_rotations.resize(count);
+  data->_shCoefficients.assign(sh, sh + count * 3 * coeffsPerChannel);
+
+  for (size_t i = 0; i < count; ++i) {
+    const float *p = positions + i * 3;
+    const float *s = scales + i * 3;
+    const float *r = rotations + i * 4;
+    data->_xyz[i] = glm::vec4(p[0], p[1], p[2], 1.0f);
+    glm::vec3 scale(s[0], s[1], s[2]);
+    data->_scales[i] = glm::vec4(activated ? scale : glm::exp(scale), 0.0f);
+    data->_rotations[i] = glm::normalize(glm::vec4(r[0], r[1], r[2], r[3]));
+    if (!activated)
+      data->_opacities[i] = 1.0f / (1.0f + std::exp(-opacities[i]));
+  }
+  return data;
+}
+
+std::vector<GaussianRecord> GaussianBase::PackRecords() const {
+  const glm::vec4 *positions =
+      static_cast<const glm::vec4 *>(GetPositionsData());
+  const glm::vec4 *scales = static_cast<const glm::vec4 *>(GetScalesData());
+  const glm::vec4 *rotations =
+      static_cast<const glm::vec4 *>(GetRotationsData());
+  const float *opacities = static_cast<const float *>(GetOpacitiesData());
+
+  std::vector<GaussianRecord> records(_numGaussians);
+  for (size_t i = 0; i < _numGaussians; ++i) {
+    const glm::vec4 &scale = scales[i];
+    const glm::vec4 &rot = rotations[i];
+    records[i].positionOpacity =
+        glm::vec4(glm::vec3(positions[i]), opacities[i]);
+    records[i].scaleRotation = glm::uvec4(
+        glm::packHalf2x16(glm::vec2(scale.x, scale.y)),
+        glm::packHalf2x16(glm::vec2(scale.z, rot.x)),
+        glm::packHalf2x16(glm::vec2(rot.y, rot.z)),
+        glm::packHalf2x16(glm::vec2(rot.w, 0.0f)));
+  }
+  return records;
+}
+
+std::vector<uint32_t> GaussianBase::EncodeSH(SHStorage mode) const {
+  const uint32_t values = 3 * uint32_t(GetSHCoefficientsPerChannel());
+  const uint32_t stride = SHStorageStride(mode, GetSHCoefficientsPerChannel());
+  const float *sh = static_cast<const float *>(GetSHData());
+
+  std::vector<uint32_t> encoded(_numGaussians * stride, 0u);
+  for (size_t i = 0; i < _numGaussians; ++i) {
+    const float *src = sh + i * values;
+    uint32_t *dst = encoded.data() + i * stride;
+
+    switch (mode) {
+    case SHStorage::Float32:
+      std::memcpy(dst, src, values * sizeof(float));
+      break;
+    case SHStorage::Half:
+      for (uint32_t v = 0; v < values; v += 2) {
+        float high = v + 1 < values ? src[v + 1] : 0.0f;
+        dst[v / 2] = glm::packHalf2x16(glm::vec2(src[v], high));
+      }
+      break;
+    case SHStorage::Quant8:
+      EncodeQuant8(src, values, dst);
+      break;
+    case SHStorage::DCFloatRestQuant8:
+      // DC dominates the color, only the view dependent terms are quantized
+      std::memcpy(dst, src, 3 * sizeof(float));
+      EncodeQuant8(src + 3, values - 3, dst + 3);
+      break;
+    }
+  }
+  return encoded;
+}
+
+void GaussianBase::BuildClusters(std::vector<uint32_t> &order,
+                                 std::vector<GaussianCluster> &clusters) const {
+  const glm::vec4 *positions =
+      static_cast<const glm::vec4 *>(GetPositionsData());
+  const glm::vec4 *scales = static_cast<const glm::vec4 *>(GetScalesData());
+
+  glm::vec3 lo(std::numeric_limits<float>::max());
+  glm::vec3 hi(std::numeric_limits<float>::lowest());
+  for (size_t i = 0; i < _numGaussians; ++i) {
+    lo = glm::min(lo, glm::vec3(positions[i]));
+    hi = glm::max(hi, glm::vec3(positions[i]));
+  }
+  glm::vec3 extent = glm::max(hi - lo, glm::vec3(1e-6f));
+
+  // Morton code in the high bits, index in the low ones: one sort of plain
+  // integers, ties keep the file order
+  std::vector<uint64_t> keys(_numGaussians);
+  for (size_t i = 0; i < _numGaussians; ++i) {
+    glm::vec3 cell = (glm::vec3(positions[i]) - lo) / extent * 1023.0f;
+    glm::uvec3 q = glm::uvec3(glm::clamp(cell, 0.0f, 1023.0f));
+    uint64_t code =
+        SpreadBits(q.x) | (SpreadBits(q.y) << 1) | (SpreadBits(q.z) << 2);
+    keys[i] = (code << 32) | uint64_t(i);
+  }
+  std::sort(keys.begin(), keys.end());
+
+  order.resize(_numGaussians);
+  for (size_t i = 0; i < _numGaussians; ++i)
+    order[i] = uint32_t(keys[i]);
+
+  size_t count = (_numGaussians + GAUSSIAN_CLUSTER_SIZE - 1) /
+                 GAUSSIAN_CLUSTER_SIZE;
+  clusters.assign(count, GaussianCluster{});
+  for (size_t c = 0; c < count; ++c) {
+    GaussianCluster &cluster = clusters[c];
+    cluster.first = uint32_t(c * GAUSSIAN_CLUSTER_SIZE);
+    cluster.count = uint32_t(std::min<size_t>(
+        GAUSSIAN_CLUSTER_SIZE, _numGaussians - cluster.first));
+    const uint32_t *members = order.data() + cluster.first;
+
+    glm::vec3 center(0.0f);
+    for (uint32_t m = 0; m < cluster.count; ++m)
+      center += glm::vec3(positions[members[m]]);
+    center /= float(cluster.count);
+
+    float radius = 0.0f, maxScale = 0.0f;
+    for (uint32_t m = 0; m < cluster.count; ++m) {
+      const glm::vec4 &scale = scales[members[m]];
+      radius = std::max(radius,
+                        glm::length(glm::vec3(positions[members[m]]) - center));
+      maxScale = std::max({maxScale, scale.x, scale.y, scale.z});
+    }
+    cluster.centerRadius = glm::vec4(center, radius);
+    cluster.extent = 3.0f * maxScale;
+  }
+}
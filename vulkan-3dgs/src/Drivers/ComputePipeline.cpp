@@ -7,24 +7,57 @@ void ComputePipeline::Initialize(GaussianBuffers gaussianBuffer) {
   std::cout << "\n === Compute Pipeline Initalization === \n" << std::endl;
 
   _gaussianBuffers = gaussianBuffer;
-  bool resultInBufferB = (_numSteps % 2) == 1;
-  _resultBufferPrefix = resultInBufferB
-                            ? _gaussianBuffers.tilesTouched
-                            : _gaussianBuffers.tilesTouchedPrefixSum;
   CreateCommandBuffers();
   CreateDescriptorPool();
 
   std::string shaderPath = g_renderSettings.shaderPath;
 
+  _preprocessShader = "Shaders/preprocess.spv";
+  std::string covarianceShader = "Shaders/covariance.spv";
+  if constexpr (GAUSSIAN_LAYOUT == GaussianLayout::Packed) {
+    // One record buffer at binding 1 replaces xyz and opacity
+    auto &layout = SHADER_LAYOUTS[PipelineType::PREPROCESS];
+    std::erase_if(layout, [](const DescriptorBinding &binding) {
+      return binding.binding == 4;
+    });
+    for (auto &binding : layout) {
+      if (binding.binding == 1)
+        binding.name = "records";
+    }
+    _preprocessShader = "Shaders/preprocess_packed.spv";
+
+    // and at binding 0 scales and rotations for the covariance cache
+    auto &covLayout = SHADER_LAYOUTS[PipelineType::COVARIANCE];
+    std::erase_if(covLayout, [](const DescriptorBinding &binding) {
+      return binding.binding == 1;
+    });
+    covLayout[0].name = "records";
+    covarianceShader = "Shaders/covariance_packed.spv";
+  }
+
+  CreatePreprocessSpecialization();
+  CreateTileSpecialization();
   CreateDescriptorSetLayout(PipelineType::PREPROCESS);
-  CreateComputePipeline(shaderPath + "Shaders/preprocess.spv",
-                        PipelineType::PREPROCESS, 4);
+  CreateComputePipeline(shaderPath + _preprocessShader,
+                        PipelineType::PREPROCESS, 8, &_preprocessSpecInfo);
   SetupDescriptorSet(PipelineType::PREPROCESS);
   UpdateAllDescriptorSets(PipelineType::PREPROCESS);
 
+  CreateDescriptorSetLayout(PipelineType::COVARIANCE);
+  CreateComputePipeline(shaderPath + covarianceShader,
+                        PipelineType::COVARIANCE, 2, &_preprocessSpecInfo);
+  SetupDescriptorSet(PipelineType::COVARIANCE);
+  UpdateAllDescriptorSets(PipelineType::COVARIANCE);
+
+  CreateDescriptorSetLayout(PipelineType::CLUSTER_CULL);
+  CreateComputePipeline(shaderPath + "Shaders/cluster_cull.spv",
+                        PipelineType::CLUSTER_CULL, 5);
+  SetupDescriptorSet(PipelineType::CLUSTER_CULL);
+  UpdateAllDescriptorSets(PipelineType::CLUSTER_CULL);
+
   CreateDescriptorSetLayout(PipelineType::PREFIXSUM);
   CreateComputePipeline(shaderPath + "Shaders/sum.spv", PipelineType::PREFIXSUM,
-                        3);
+                        1);
   SetupDescriptorSet(PipelineType::PREFIXSUM);
   UpdateAllDescriptorSets(PipelineType::PREFIXSUM);
 
@@ -33,18 +66,63 @@ void ComputePipeline::Initialize(GaussianBuffers gaussianBuffer) {
    SetupDescriptorSet(PipelineType::NEAREST);
    UpdateAllDescriptorSets(PipelineType::NEAREST);*/
 
+  CreateDescriptorSetLayout(PipelineType::DEPTH_BUDGET);
+  CreateComputePipeline(shaderPath + "Shaders/depth_budget.spv",
+                        PipelineType::DEPTH_BUDGET, 3);
+  SetupDescriptorSet(PipelineType::DEPTH_BUDGET);
+  UpdateAllDescriptorSets(PipelineType::DEPTH_BUDGET);
+
+  CreateDescriptorSetLayout(PipelineType::DISPATCH_ARGS);
+  CreateComputePipeline(shaderPath + "Shaders/dispatch_args.spv",
+                        PipelineType::DISPATCH_ARGS, 2);
+  SetupDescriptorSet(PipelineType::DISPATCH_ARGS);
+  UpdateAllDescriptorSets(PipelineType::DISPATCH_ARGS);
+
   CreateDescriptorSetLayout(PipelineType::ASSIGN_TILE_IDS);
   CreateComputePipeline(shaderPath + "Shaders/idkeys.spv",
-                        PipelineType::ASSIGN_TILE_IDS, 3);
+                        PipelineType::ASSIGN_TILE_IDS, 8, &_tileSpecInfo[0]);
+  CreateComputePipelineKey32(shaderPath + "Shaders/idkeys32.spv",
+                             PipelineType::ASSIGN_TILE_IDS, &_tileSpecInfo[0]);
   SetupDescriptorSet(PipelineType::ASSIGN_TILE_IDS);
   UpdateAllDescriptorSets(PipelineType::ASSIGN_TILE_IDS);
+  SetupDescriptorSet(PipelineType::ASSIGN_TILE_IDS_1);
+  UpdateAllDescriptorSets(PipelineType::ASSIGN_TILE_IDS_1);
 
+  CreateSortSpecialization();
   CreateDescriptorSetLayout(PipelineType::RADIX_HISTOGRAM_0);
   CreateComputePipeline(shaderPath + "Shaders/histogram.spv",
-                        PipelineType::RADIX_HISTOGRAM_0, 4);
+                        PipelineType::RADIX_HISTOGRAM_0, 2, &_sortSpecInfo);
+  CreateComputePipelineKey32(shaderPath + "Shaders/histogram32.spv",
+                             PipelineType::RADIX_HISTOGRAM_0, &_sortSpecInfo);
   CreateDescriptorSetLayout(PipelineType::RADIX_SCATTER_0);
   CreateComputePipeline(shaderPath + "Shaders/sort.spv",
-                        PipelineType::RADIX_SCATTER_0, 4);
+                        PipelineType::RADIX_SCATTER_0, 2, &_sortSpecInfo);
+  CreateComputePipelineKey32(shaderPath + "Shaders/sort32.spv",
+                             PipelineType::RADIX_SCATTER_0, &_sortSpecInfo);
+  // Key width independent, reads only the histograms
+  CreateSharedLayoutPipeline(shaderPath + "Shaders/histogram_scan.spv",
+                             PipelineType::RADIX_SCAN,
+                             PipelineType::RADIX_HISTOGRAM_0, false,
+                             &_sortSpecInfo);
+
+  // Onesweep engine: same bindings and push constant size as the classic
+  // sort, so it reuses its layouts and ping-pong descriptor sets
+  CreateSharedLayoutPipeline(shaderPath + "Shaders/onesweep_histogram.spv",
+                             PipelineType::ONESWEEP_HISTOGRAM,
+                             PipelineType::RADIX_HISTOGRAM_0, false,
+                             &_sortSpecInfo);
+  CreateSharedLayoutPipeline(shaderPath + "Shaders/onesweep_histogram32.spv",
+                             PipelineType::ONESWEEP_HISTOGRAM,
+                             PipelineType::RADIX_HISTOGRAM_0, true,
+                             &_sortSpecInfo);
+  CreateSharedLayoutPipeline(shaderPath + "Shaders/onesweep.spv",
+                             PipelineType::ONESWEEP_SCATTER,
+                             PipelineType::RADIX_SCATTER_0, false,
+                             &_sortSpecInfo);
+  CreateSharedLayoutPipeline(shaderPath + "Shaders/onesweep32.spv",
+                             PipelineType::ONESWEEP_SCATTER,
+                             PipelineType::RADIX_SCATTER_0, true,
+                             &_sortSpecInfo);
 
   SetupDescriptorSet(PipelineType::RADIX_HISTOGRAM_0);
   UpdateAllDescriptorSets(PipelineType::RADIX_HISTOGRAM_0);
@@ -60,18 +138,21 @@ void ComputePipeline::Initialize(GaussianBuffers gaussianBuffer) {
 
   CreateDescriptorSetLayout(PipelineType::TILE_BOUNDARIES);
   CreateComputePipeline(shaderPath + "Shaders/boundaries.spv",
-                        PipelineType::TILE_BOUNDARIES, 1);
+                        PipelineType::TILE_BOUNDARIES, 2);
+  CreateComputePipelineKey32(shaderPath + "Shaders/boundaries32.spv",
+                             PipelineType::TILE_BOUNDARIES);
   SetupDescriptorSet(PipelineType::TILE_BOUNDARIES);
   UpdateAllDescriptorSets(PipelineType::TILE_BOUNDARIES);
 
   CreateDescriptorSetLayout(PipelineType::RENDER);
-#ifdef SHARED_MEM_RENDERING
-  CreateComputePipeline(shaderPath + "Shaders/render_shared.spv",
-                        PipelineType::RENDER, 4);
-#else
   CreateComputePipeline(shaderPath + "Shaders/render.spv", PipelineType::RENDER,
-                        4);
-#endif
+                        4, &_tileSpecInfo[0]);
+  CreateSharedLayoutPipeline(shaderPath + "Shaders/render_shared.spv",
+                             PipelineType::RENDER_SHARED, PipelineType::RENDER,
+                             false, &_tileSpecInfo[0]);
+  CreateSharedLayoutPipeline(shaderPath + "Shaders/render_shared.spv",
+                             PipelineType::RENDER_SHARED_SUBTILE,
+                             PipelineType::RENDER, false, &_tileSpecInfo[1]);
   createRenderTarget();
   SetupDescriptorSet(PipelineType::RENDER);
   UpdateAllDescriptorSets(PipelineType::RENDER);
@@ -85,6 +166,16 @@ void ComputePipeline::Initialize(GaussianBuffers gaussianBuffer) {
   UpdateAllDescriptorSets(PipelineType::UPSAMPLING);
 #endif
   CreateSynchronization();
+  _profiler.Init(_vkContext.GetPhysicalDevice(), _vkContext.GetLogicalDevice(),
+                 _vkContext.GetGraphicsFamily(), frames_in_flight);
+  _imGuiHandler.setProfiler(&_profiler);
+  if (_vkContext.IsHeadless())
+    CreateReadbackBuffers();
+
+  size_t imageCount = _vkContext.GetSwapchainImages().size();
+  _imageSortGeneration.assign(imageCount, 0);
+  _imageSubmitFrame.assign(imageCount, 0);
+  _sortCapacityCap = SortCapacityCap();
 
   // RecordAllCommandBuffers();
   std::cout << "\n=== Compute Pipeline Initialization Complete ===\n"
@@ -119,6 +210,8 @@ void ComputePipeline::CleanUp() {
   }
   _semaphores.clear();
 
+  _profiler.CleanUp();
+
   _commandBuffers.clear();
 
   if (_computePipelines[PipelineType::DEBUG_RED_FILL] != VK_NULL_HANDLE) {
@@ -208,6 +301,114 @@ void ComputePipeline::CreateSynchronization() {
   std::cout << " Created Sempahores and Fences " << std::endl;
 }
 
+void ComputePipeline::CreateReadbackBuffers() {
+  // Offscreen images are cycled with the frame slots
+  if (_vkContext.GetSwapchainImages().size() < frames_in_flight)
+    throw std::runtime_error("Headless mode needs an offscreen image per "
+                             "frame in flight");
+
+  VkExtent2D extent = _vkContext.GetSwapchainExtent();
+  VkDeviceSize size = VkDeviceSize(extent.width) * extent.height * 4;
+
+  // Uncached host memory makes reading the pixels back very slow, so take
+  // cached memory where the device has it
+  VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  try {
+    findMemoryType(~0u, properties | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+    properties |= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+  } catch (const std::runtime_error &) {
+  }
+
+  for (StagingRead &readback : _readback) {
+    readback.staging = _buffManager->CreateBuffer(
+        _vkContext.GetLogicalDevice(), _vkContext.GetPhysicalDevice(), size,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT, properties);
+    readback.mem = _buffManager->MapBuffer(readback.staging);
+  }
+  std::cout << " Created headless readback buffers: " << frames_in_flight
+            << " x " << size << " bytes" << std::endl;
+}
+
+// After the fence wait of this frame slot
+void ComputePipeline::DeliverReadback(uint32_t frame) {
+  uint64_t frameNumber = _readbackFrame[frame];
+  if (frameNumber == 0)
+    return;
+  _readbackFrame[frame] = 0;
+  if (!_readbackCallback)
+    return;
+
+  VkExtent2D extent = _vkContext.GetSwapchainExtent();
+  _readbackCallback({frameNumber, extent.width, extent.height,
+                     static_cast<const uint8_t *>(_readback[frame].mem),
+                     ReadDroppedKeys(frame)});
+}
+
+void ComputePipeline::FlushReadbacks() {
+  // Oldest slot first, so frames arrive in submission order
+  for (uint32_t i = 0; i < frames_in_flight; i++) {
+    uint32_t frame = (_currentFrame + i) % frames_in_flight;
+    if (_readbackFrame[frame] == 0)
+      continue;
+    vkWaitForFences(_vkContext.GetLogicalDevice(), 1, &_renderFences[frame],
+                    VK_TRUE, UINT64_MAX);
+    DeliverReadback(frame);
+  }
+}
+
+void ComputePipeline::RecordImageReadback(VkCommandBuffer commandBuffer,
+                                          uint32_t imageIndex) {
+  // Last writer is the render dispatch or the clear, the image stays in
+  // GENERAL for the next frame
+  VkImage image = _vkContext.GetSwapchainImages()[imageIndex].image;
+  VkImageMemoryBarrier imageBarrier = {};
+  imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  imageBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+  imageBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+  imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  imageBarrier.image = image;
+  imageBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+  imageBarrier.srcAccessMask =
+      VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+  imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                           VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &imageBarrier);
+
+  VkExtent2D extent = _vkContext.GetSwapchainExtent();
+  VkBufferImageCopy region = {};
+  region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  region.imageExtent = {extent.width, extent.height, 1};
+  vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL,
+                         _readback[_currentFrame].staging, 1, &region);
+
+  VkMemoryBarrier hostBarrier = {};
+  hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0,
+                       nullptr, 0, nullptr);
+  _readbackFrame[_currentFrame] = _frameNumber;
+}
+
+// After the fence wait of this frame slot
+void ComputePipeline::CollectGpuTimings(uint32_t frame) {
+  if (!_profiler.Collect(frame))
+    return;
+
+  float ms = _profiler.LastStageMs("render");
+  if (ms < 0.0f)
+    return;
+  float &average =
+      g_renderSettings.rasterTimeMs[int(_rasterTimedMode[frame])];
+  average = average == 0.0f ? ms : average + 0.05f * (ms - average);
+}
+
 void ComputePipeline::CreateDescriptorSetLayout(const PipelineType pType) {
 
   std::vector<VkDescriptorSetLayoutBinding> vulkanBindings;
@@ -240,9 +441,9 @@ void ComputePipeline::CreateDescriptorSetLayout(const PipelineType pType) {
             << " bindings)" << std::endl;
 }
 
-void ComputePipeline::CreateComputePipeline(std::string shaderName,
-                                            const PipelineType pType,
-                                            int numPushConstants) {
+void ComputePipeline::CreateComputePipeline(
+    std::string shaderName, const PipelineType pType, int numPushConstants,
+    const VkSpecializationInfo *specInfo) {
   std::cout << "  - Loading and creating compute pipeline..." << std::endl;
   auto computeShaderCode = ReadFile(shaderName);
   VkShaderModule computeShader = CreateShaderModule(computeShaderCode);
@@ -253,6 +454,7 @@ void ComputePipeline::CreateComputePipeline(std::string shaderName,
   computeShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
   computeShaderStageInfo.module = computeShader;
   computeShaderStageInfo.pName = "main";
+  computeShaderStageInfo.pSpecializationInfo = specInfo;
 
   VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
   pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -298,6 +500,210 @@ void ComputePipeline::CreateComputePipeline(std::string shaderName,
             << " using shader: " << shaderName << std::endl;
 }
 
+void ComputePipeline::CreateComputePipelineKey32(
+    std::string shaderName, const PipelineType pType,
+    const VkSpecializationInfo *specInfo) {
+  CreateSharedLayoutPipeline(shaderName, pType, pType, true, specInfo);
+}
+
+void ComputePipeline::CreateSharedLayoutPipeline(
+    std::string shaderName, const PipelineType pType,
+    const PipelineType layoutType, bool key32,
+    const VkSpecializationInfo *specInfo) {
+  auto computeShaderCode = ReadFile(shaderName);
+  VkShaderModule computeShader = CreateShaderModule(computeShaderCode);
+
+  VkPipelineShaderStageCreateInfo computeShaderStageInfo = {};
+  computeShaderStageInfo.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  computeShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  computeShaderStageInfo.module = computeShader;
+  computeShaderStageInfo.pName = "main";
+  computeShaderStageInfo.pSpecializationInfo = specInfo;
+
+  VkComputePipelineCreateInfo pipelineInfo = {};
+  pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipelineInfo.layout = _pipelineLayouts[layoutType];
+  pipelineInfo.stage = computeShaderStageInfo;
+
+  auto &pipelines = key32 ? _computePipelines32 : _computePipelines;
+  if (vkCreateComputePipelines(_vkContext.GetLogicalDevice(), VK_NULL_HANDLE, 1,
+                               &pipelineInfo, nullptr,
+                               &pipelines[pType]) != VK_SUCCESS) {
+    vkDestroyShaderModule(_vkContext.GetLogicalDevice(), computeShader,
+                          nullptr);
+    throw std::runtime_error("Failed to create compute pipeline!");
+  }
+  vkDestroyShaderModule(_vkContext.GetLogicalDevice(), computeShader, nullptr);
+  std::cout << (key32 ? "32-bit key pipeline" : "Compute pipeline")
+            << " created for pipeline type " << (int)pType
+            << " using shader: " << shaderName << std::endl;
+}
+
+void ComputePipeline::CreateSortSpecialization() {
+  _sortSpecData.minSubgroupSize = _vkContext.GetMinSubgroupSize();
+  _sortSpecData.workgroupSize = WORKGROUP_SIZE;
+  _sortSpecData.blocksPerWorkgroup = blocks_per_workgroup;
+
+  _sortSpecEntries[0] = {0,
+                         offsetof(decltype(_sortSpecData), minSubgroupSize),
+                         sizeof(uint32_t)};
+  _sortSpecEntries[1] = {1, offsetof(decltype(_sortSpecData), workgroupSize),
+                         sizeof(uint32_t)};
+  _sortSpecEntries[2] = {
+      2, offsetof(decltype(_sortSpecData), blocksPerWorkgroup),
+      sizeof(uint32_t)};
+
+  _sortSpecInfo.mapEntryCount = 3;
+  _sortSpecInfo.pMapEntries = _sortSpecEntries;
+  _sortSpecInfo.dataSize = sizeof(_sortSpecData);
+  _sortSpecInfo.pData = &_sortSpecData;
+}
+
+void ComputePipeline::CreatePreprocessSpecialization() {
+  _preprocessSpecData.shStorage =
+      static_cast<uint32_t>(g_renderSettings.shStorage);
+  _preprocessSpecData.tileWidth = _tileWidth;
+  _preprocessSpecData.tileHeight = _tileHeight;
+  _preprocessSpecData.covStorage =
+      static_cast<uint32_t>(g_renderSettings.covStorage);
+  _preprocessSpecEntries[0] = {
+      0, offsetof(decltype(_preprocessSpecData), shStorage), sizeof(uint32_t)};
+  _preprocessSpecEntries[1] = {
+      1, offsetof(decltype(_preprocessSpecData), tileWidth), sizeof(uint32_t)};
+  _preprocessSpecEntries[2] = {
+      2, offsetof(decltype(_preprocessSpecData), tileHeight), sizeof(uint32_t)};
+  _preprocessSpecEntries[3] = {
+      3, offsetof(decltype(_preprocessSpecData), covStorage), sizeof(uint32_t)};
+
+  _preprocessSpecInfo.mapEntryCount = 4;
+  _preprocessSpecInfo.pMapEntries = _preprocessSpecEntries;
+  _preprocessSpecInfo.dataSize = sizeof(_preprocessSpecData);
+  _preprocessSpecInfo.pData = &_preprocessSpecData;
+}
+
+void ComputePipeline::CreateTileSpecialization() {
+  _tileSpecData[0] = {_tileWidth, _tileHeight, _tileWidth, _tileHeight};
+  _tileSpecData[1] = {_tileWidth, _tileHeight, _tileWidth / 2,
+                      _tileHeight / 2};
+
+  _tileSpecEntries[0] = {0, offsetof(TileSpecData, tileWidth),
+                         sizeof(uint32_t)};
+  _tileSpecEntries[1] = {1, offsetof(TileSpecData, tileHeight),
+                         sizeof(uint32_t)};
+  _tileSpecEntries[2] = {2, offsetof(TileSpecData, groupWidth),
+                         sizeof(uint32_t)};
+  _tileSpecEntries[3] = {3, offsetof(TileSpecData, groupHeight),
+                         sizeof(uint32_t)};
+
+  // idkeys and render.comp ignore the entries of ids they do not declare
+  for (int i = 0; i < 2; i++) {
+    _tileSpecInfo[i].mapEntryCount = 4;
+    _tileSpecInfo[i].pMapEntries = _tileSpecEntries;
+    _tileSpecInfo[i].dataSize = sizeof(TileSpecData);
+    _tileSpecInfo[i].pData = &_tileSpecData[i];
+  }
+}
+
+// Shared memory of render_shared_mem.comp for a workgroup of the given size:
+// collected_xy, collected_conic_opacity and collected_color (vec3 counted
+// padded to 16 bytes) per thread plus busy_subgroups
+static uint32_t RenderSharedBytes(uint32_t groupWidth, uint32_t groupHeight) {
+  return groupWidth * groupHeight * (8 + 16 + 16) + 2 * sizeof(uint32_t);
+}
+
+// The tile size changed in the settings: rebuild every pipeline specialized
+// on it. The caller has waited for the device
+void ComputePipeline::RebuildTilePipelines() {
+  uint32_t width = uint32_t(g_renderSettings.tileWidth);
+  uint32_t height = uint32_t(g_renderSettings.tileHeight);
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(_vkContext.GetPhysicalDevice(), &properties);
+  const VkPhysicalDeviceLimits &limits = properties.limits;
+  uint32_t oldWidth = _tileWidth;
+  uint32_t oldHeight = _tileHeight;
+  if (width < MIN_TILE_DIM || height < MIN_TILE_DIM ||
+      width > limits.maxComputeWorkGroupSize[0] ||
+      height > limits.maxComputeWorkGroupSize[1] ||
+      width * height > limits.maxComputeWorkGroupInvocations ||
+      RenderSharedBytes(width, height) > limits.maxComputeSharedMemorySize) {
+    std::cerr << "Tile size " << width << "x" << height
+              << " not supported, keeping " << oldWidth << "x" << oldHeight
+              << std::endl;
+    g_renderSettings.tileWidth = int(oldWidth);
+    g_renderSettings.tileHeight = int(oldHeight);
+    return;
+  }
+
+  _tileWidth = width;
+  _tileHeight = height;
+  CreatePreprocessSpecialization();
+  CreateTileSpecialization();
+
+  // The new pipelines are built next to the old ones, which are destroyed
+  // only once all of them exist. A failure keeps the previous tile size
+  VkDevice device = _vkContext.GetLogicalDevice();
+  VkPipeline *slots[] = {
+      &_computePipelines[PipelineType::PREPROCESS],
+      &_computePipelines[PipelineType::ASSIGN_TILE_IDS],
+      &_computePipelines32[PipelineType::ASSIGN_TILE_IDS],
+      &_computePipelines[PipelineType::RENDER],
+      &_computePipelines[PipelineType::RENDER_SHARED],
+      &_computePipelines[PipelineType::RENDER_SHARED_SUBTILE]};
+  VkPipeline oldPipelines[std::size(slots)];
+  for (size_t i = 0; i < std::size(slots); i++) {
+    oldPipelines[i] = *slots[i];
+    *slots[i] = VK_NULL_HANDLE;
+  }
+
+  std::string shaderPath = g_renderSettings.shaderPath;
+  try {
+    CreateSharedLayoutPipeline(
+        shaderPath + _preprocessShader, PipelineType::PREPROCESS,
+        PipelineType::PREPROCESS, false, &_preprocessSpecInfo);
+    CreateSharedLayoutPipeline(shaderPath + "Shaders/idkeys.spv",
+                               PipelineType::ASSIGN_TILE_IDS,
+                               PipelineType::ASSIGN_TILE_IDS, false,
+                               &_tileSpecInfo[0]);
+    CreateComputePipelineKey32(shaderPath + "Shaders/idkeys32.spv",
+                               PipelineType::ASSIGN_TILE_IDS,
+                               &_tileSpecInfo[0]);
+    CreateSharedLayoutPipeline(shaderPath + "Shaders/render.spv",
+                               PipelineType::RENDER, PipelineType::RENDER,
+                               false, &_tileSpecInfo[0]);
+    CreateSharedLayoutPipeline(shaderPath + "Shaders/render_shared.spv",
+                               PipelineType::RENDER_SHARED,
+                               PipelineType::RENDER, false, &_tileSpecInfo[0]);
+    CreateSharedLayoutPipeline(shaderPath + "Shaders/render_shared.spv",
+                               PipelineType::RENDER_SHARED_SUBTILE,
+                               PipelineType::RENDER, false, &_tileSpecInfo[1]);
+  } catch (const std::exception &e) {
+    for (size_t i = 0; i < std::size(slots); i++) {
+      vkDestroyPipeline(device, *slots[i], nullptr);
+      *slots[i] = oldPipelines[i];
+    }
+    _tileWidth = oldWidth;
+    _tileHeight = oldHeight;
+    CreatePreprocessSpecialization();
+    CreateTileSpecialization();
+    g_renderSettings.tileWidth = int(oldWidth);
+    g_renderSettings.tileHeight = int(oldHeight);
+    std::cerr << "Tile size " << width << "x" << height << " failed ("
+              << e.what() << "), keeping " << oldWidth << "x" << oldHeight
+              << std::endl;
+    return;
+  }
+  for (VkPipeline pipeline : oldPipelines)
+    vkDestroyPipeline(device, pipeline, nullptr);
+
+  // Timings of the previous tile size are not comparable
+  std::fill(std::begin(g_renderSettings.rasterTimeMs),
+            std::end(g_renderSettings.rasterTimeMs), 0.0f);
+  std::cout << "Tile size set to " << _tileWidth << "x" << _tileHeight
+            << std::endl;
+}
+
 void ComputePipeline::SetupDescriptorSet(const PipelineType pType) {
   std::cout << "  - Setting up descriptor sets for pipeline type " << (int)pType
             << "..." << std::endl;
@@ -317,6 +723,10 @@ void ComputePipeline::SetupDescriptorSet(const PipelineType pType) {
     layouts = std::vector<VkDescriptorSetLayout>(
         swapchainImageCount,
         _descriptorSetLayouts[PipelineType::RADIX_SCATTER_0]);
+  } else if (pType == PipelineType::ASSIGN_TILE_IDS_1) {
+    layouts = std::vector<VkDescriptorSetLayout>(
+        swapchainImageCount,
+        _descriptorSetLayouts[PipelineType::ASSIGN_TILE_IDS]);
   } else {
     layouts = std::vector<VkDescriptorSetLayout>(swapchainImageCount,
                                                  _descriptorSetLayouts[pType]);
@@ -348,14 +758,141 @@ void ComputePipeline::RecordCommandPreprocess(uint32_t imageIndex) {
   if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
     throw std::runtime_error("Failed to begin recording command buffer!");
   }
+
+  _profiler.BeginFrame(commandBuffer, _currentFrame);
+  RecordPreprocessPass(commandBuffer, imageIndex);
+
+  VkBufferCopy copyRegion = {};
+  copyRegion.srcOffset = offsetof(VisibleArgs, totalTiles);
+  copyRegion.dstOffset = 0;
+  copyRegion.size = sizeof(uint32_t);
+
+  vkCmdCopyBuffer(commandBuffer, _gaussianBuffers.visibleArgs,
+                  _gaussianBuffers.numRendered.staging, 1, &copyRegion);
+
+  //////////////////////////////////////////////////////////////////////////////////////
+  // End recording
+  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to record command buffer!");
+  }
+
+  /*std::cout << " Command buffer recorded for swapchain image " << imageIndex
+            << std::endl;*/
+}
+
+void ComputePipeline::RecordCommandRender(uint32_t imageIndex, int numRendered,
+                                          Camera &cam) {
+  VkCommandBuffer commandBuffer = _renderCommandBuffers[imageIndex];
+
+  // Begin recording
+  VkCommandBufferBeginInfo beginInfo = {};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = 0; // Not one-time submit
+
+  if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to begin recording command buffer!");
+  }
+
+  RecordRenderPass(commandBuffer, imageIndex, numRendered, cam, false);
+  RecordKeyCountReadback(commandBuffer);
+
+  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to record command buffer!");
+  }
+}
+
+void ComputePipeline::RecordCommandFrame(uint32_t imageIndex, Camera &cam) {
+  VkCommandBuffer commandBuffer = _renderCommandBuffers[imageIndex];
+
+  VkCommandBufferBeginInfo beginInfo = {};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = 0;
+
+  if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to begin recording command buffer!");
+  }
+
+  _profiler.BeginFrame(commandBuffer, _currentFrame);
+  RecordPreprocessPass(commandBuffer, imageIndex);
+
+  VkMemoryBarrier prefixBarrier = {};
+  prefixBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  prefixBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  prefixBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                       &prefixBarrier, 0, nullptr, 0, nullptr);
+
+  RecordRenderPass(commandBuffer, imageIndex, 0, cam, true);
+  RecordKeyCountReadback(commandBuffer);
+
+  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to record command buffer!");
+  }
+}
+
+void ComputePipeline::UpdateTileStats() {
+  // Slots were written by the frame that last used this fence
+  TileStats stats = ReadTileStats(_currentFrame);
+  uint32_t keys = ReadRequestedKeys(_currentFrame);
+  float visible = float(std::max(stats.visibleGaussians, 1u));
+  g_renderSettings.keysPerGaussian = float(keys) / visible;
+  g_renderSettings.aabbKeysPerGaussian = float(stats.aabbKeys) / visible;
+  for (int d = 0; d < 4; d++)
+    g_renderSettings.shDegreeGaussians[d] = int(stats.shDegreeGaussians[d]);
+  g_renderSettings.visibleClusters = int(stats.visibleClusters);
+  g_renderSettings.clusterGaussians = int(stats.clusterGaussians);
+}
+
+void ComputePipeline::RecordKeyCountReadback(VkCommandBuffer commandBuffer) {
+  // Requested and dropped key counts are read back one frame late to size
+  // the sort buffers, nothing waits on them this frame
+  VkMemoryBarrier argsBarrier = {};
+  argsBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  argsBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  argsBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &argsBarrier, 0,
+                       nullptr, 0, nullptr);
+
+  VkBufferCopy copyRegions[2] = {};
+  copyRegions[0].srcOffset = offsetof(DispatchArgs, requested);
+  copyRegions[0].dstOffset = (1 + _currentFrame) * sizeof(uint32_t);
+  copyRegions[0].size = sizeof(uint32_t);
+  copyRegions[1].srcOffset = offsetof(DispatchArgs, dropped);
+  copyRegions[1].dstOffset =
+      (1 + frames_in_flight + _currentFrame) * sizeof(uint32_t);
+  copyRegions[1].size = sizeof(uint32_t);
+  vkCmdCopyBuffer(commandBuffer, _gaussianBuffers.dispatchArgs,
+                  _gaussianBuffers.numRendered.staging, 2, copyRegions);
+
+  VkBufferCopy statsRegion = {};
+  statsRegion.dstOffset = TileStatsSlot(_currentFrame) * sizeof(uint32_t);
+  statsRegion.size = sizeof(TileStats);
+  vkCmdCopyBuffer(commandBuffer, _gaussianBuffers.tileStats,
+                  _gaussianBuffers.numRendered.staging, 1, &statsRegion);
+
+  VkMemoryBarrier hostBarrier = {};
+  hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0,
+                       nullptr, 0, nullptr);
+}
+
+void ComputePipeline::RecordPreprocessPass(VkCommandBuffer commandBuffer,
+                                           uint32_t imageIndex) {
   /////////////////////////////////////////////////////////////////////////////////////
   // Transition image to GENERAL
   static std::vector<bool> firstFrame(_vkContext.GetSwapchainImages().size(),
                                       true);
 
-  VkImageLayout srcLayout = firstFrame[imageIndex]
-                                ? VK_IMAGE_LAYOUT_UNDEFINED
-                                : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  VkImageLayout srcLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  if (firstFrame[imageIndex])
+    srcLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  else if (_vkContext.IsHeadless())
+    srcLayout = VK_IMAGE_LAYOUT_GENERAL; // left there by the readback
   firstFrame[imageIndex] = false;
 
   TransitionImage(commandBuffer, srcLayout, // Use correct source layout
@@ -365,9 +902,93 @@ void ComputePipeline::RecordCommandPreprocess(uint32_t imageIndex) {
                   VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
                   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
 
+  /////////////////////////////////////////////////////////////////////////////////////
+  // Camera uniforms. The previous frame may still be reading them and the
+  // intermediate buffers, so wait for its compute work first
+
+  VkMemoryBarrier frameBarrier = {};
+  frameBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  frameBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  frameBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT |
+                              VK_ACCESS_SHADER_WRITE_BIT |
+                              VK_ACCESS_TRANSFER_WRITE_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                           VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       0, 1, &frameBarrier, 0, nullptr, 0, nullptr);
+
+  vkCmdUpdateBuffer(commandBuffer, _gaussianBuffers.camUniform, 0,
+                    sizeof(CameraUniforms), &_cameraUniforms);
+  vkCmdFillBuffer(commandBuffer, _gaussianBuffers.tileStats, 0,
+                  sizeof(TileStats), 0);
+  // Empty visible set, preprocess grows the workgroup counts as it appends
+  VisibleArgs visibleArgs = {};
+  visibleArgs.visibleDispatch = {0, 1, 1};
+  visibleArgs.prefixDispatch = {0, 1, 1};
+  visibleArgs.preprocessDispatch = {0, 1, 1};
+  vkCmdUpdateBuffer(commandBuffer, _gaussianBuffers.visibleArgs, 0,
+                    sizeof(VisibleArgs), &visibleArgs);
+
+  VkMemoryBarrier uniformBarrier = {};
+  uniformBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  uniformBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  uniformBarrier.dstAccessMask = VK_ACCESS_UNIFORM_READ_BIT |
+                                 VK_ACCESS_SHADER_READ_BIT |
+                                 VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                       &uniformBarrier, 0, nullptr, 0, nullptr);
+
+  // View independent, only rebuilt when the scale modifier moved
+  if (g_renderSettings.splatScale != _covarianceScale)
+    RecordCovariancePass(commandBuffer, imageIndex);
+
+  /////////////////////////////////////////////////////////////////////////////////////
+  // Cluster cull, sizes the preprocess dispatch
+
+  _profiler.BeginStage(commandBuffer, "cluster cull");
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    _computePipelines[PipelineType::CLUSTER_CULL]);
+
+  uint32_t numClusters =
+      (uint32_t(_numGaussians) + GAUSSIAN_CLUSTER_SIZE - 1) /
+      GAUSSIAN_CLUSTER_SIZE;
+  struct {
+    uint32_t numClusters;
+    float nearPlane;
+    float farPlane;
+    uint32_t culling;
+    float scaleModifier;
+  } pushClusterCull = {numClusters, g_renderSettings.nearPlane,
+                       g_renderSettings.farPlane,
+                       uint32_t(g_renderSettings.enableCulling &&
+                                g_renderSettings.clusterCulling),
+                       g_renderSettings.splatScale};
+  vkCmdPushConstants(commandBuffer,
+                     _pipelineLayouts[PipelineType::CLUSTER_CULL],
+                     VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushClusterCull),
+                     &pushClusterCull);
+  vkCmdBindDescriptorSets(
+      commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+      _pipelineLayouts[PipelineType::CLUSTER_CULL], 0, 1,
+      &_descriptorSets[PipelineType::CLUSTER_CULL][imageIndex], 0, nullptr);
+  vkCmdDispatch(commandBuffer, (numClusters + 255) / 256, 1, 1);
+
+  VkMemoryBarrier cullBarrier = {};
+  cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  cullBarrier.dstAccessMask =
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                           VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                       0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+  _profiler.EndStage(commandBuffer);
+
   /////////////////////////////////////////////////////////////////////////////////////
   // Bind pipeline 1
 
+  _profiler.BeginStage(commandBuffer, "preprocess");
   vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
                     _computePipelines[PipelineType::PREPROCESS]);
 
@@ -376,9 +997,20 @@ void ComputePipeline::RecordCommandPreprocess(uint32_t imageIndex) {
     float nearPlane;
     float farPlane;
     uint32_t culling;
-  } pushPreprocess = {_numGaussians, g_renderSettings.nearPlane,
+    uint32_t exactTiles;
+    uint32_t opacityRadius;
+    float shLodRadius;
+    float shLodDistance;
+  } pushPreprocess = {_numGaussians,
+                      g_renderSettings.nearPlane,
                       g_renderSettings.farPlane,
-                      uint32_t(g_renderSettings.enableCulling)};
+                      uint32_t(g_renderSettings.enableCulling),
+                      uint32_t(g_renderSettings.exactTileTest),
+                      uint32_t(g_renderSettings.opacityAwareRadius),
+                      g_renderSettings.shLod ? g_renderSettings.shLodRadius
+                                             : 0.0f,
+                      g_renderSettings.shLod ? g_renderSettings.shLodDistance
+                                             : 0.0f};
   vkCmdPushConstants(commandBuffer, _pipelineLayouts[PipelineType::PREPROCESS],
                      VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushPreprocess),
                      &pushPreprocess);
@@ -388,22 +1020,27 @@ void ComputePipeline::RecordCommandPreprocess(uint32_t imageIndex) {
       _pipelineLayouts[PipelineType::PREPROCESS], 0, 1,
       &_descriptorSets[PipelineType::PREPROCESS][imageIndex], 0, nullptr);
 
-  uint32_t groupX = (_numGaussians + 255) / 256;
-  vkCmdDispatch(commandBuffer, groupX, 1, 1);
+  // One workgroup per cluster the cull kept
+  vkCmdDispatchIndirect(commandBuffer, _gaussianBuffers.visibleArgs,
+                        offsetof(VisibleArgs, preprocessDispatch));
 
   /////////////////////////////////////////////////////////////////////////////////////
-  // Barrier1
+  // Barrier1, the visible counts also size the dispatches that follow
   VkMemoryBarrier barrier = {};
   barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
   barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barrier.dstAccessMask =
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
 
   vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
-                       nullptr, 0, nullptr);
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                           VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                       0, 1, &barrier, 0, nullptr, 0, nullptr);
+  _profiler.EndStage(commandBuffer);
 
   ///////////////////////////////////////////////////////////////////////////////////////
   //// Prefix Sum
+  _profiler.BeginStage(commandBuffer, "scan");
 
   vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
                     _computePipelines[PipelineType::PREFIXSUM]);
@@ -412,21 +1049,19 @@ void ComputePipeline::RecordCommandPreprocess(uint32_t imageIndex) {
                           &_descriptorSets[PipelineType::PREFIXSUM][imageIndex],
                           0, nullptr);
 
-  uint32_t prefixSumGroups = (_numGaussians + 255) / 256;
-
-  for (uint32_t step = 0; step <= _numSteps; step++) {
-    struct PushConstants {
-      uint32_t step;
-      int32_t numElements;
-      int32_t readFromA;
-    } pushConstants = {step, _numGaussians, (step % 2) == 0 ? 1 : 0};
-
+  // Reduce, scan block sums, downsweep (see prefixsum.comp), over the
+  // visible Gaussians only
+  for (uint32_t scanPass = 0; scanPass < 3; scanPass++) {
     vkCmdPushConstants(commandBuffer, _pipelineLayouts[PipelineType::PREFIXSUM],
-                       VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants),
-                       &pushConstants);
-    vkCmdDispatch(commandBuffer, prefixSumGroups, 1, 1);
-
-    if (step < _numSteps - 1) {
+                       VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(scanPass),
+                       &scanPass);
+    if (scanPass == 1)
+      vkCmdDispatch(commandBuffer, 1, 1, 1);
+    else
+      vkCmdDispatchIndirect(commandBuffer, _gaussianBuffers.visibleArgs,
+                            offsetof(VisibleArgs, prefixDispatch));
+
+    if (scanPass < 2) {
       VkMemoryBarrier stepBarrier = {};
       stepBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
       stepBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
@@ -437,42 +1072,228 @@ void ComputePipeline::RecordCommandPreprocess(uint32_t imageIndex) {
     }
   }
 
-  VkBufferCopy copyRegion = {};
-  copyRegion.srcOffset = (_numGaussians - 1) * sizeof(uint32_t);
-  copyRegion.dstOffset = 0;
-  copyRegion.size = sizeof(uint32_t);
-
-  vkCmdCopyBuffer(commandBuffer, _resultBufferPrefix,
-                  _gaussianBuffers.numRendered.staging, 1, &copyRegion);
+  VkMemoryBarrier copyBarrier = {};
+  copyBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  copyBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  copyBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &copyBarrier, 0,
+                       nullptr, 0, nullptr);
+  _profiler.EndStage(commandBuffer);
 
   ///////////////////// END PREFIX SUM /////////////////////
+}
 
-  /////////////////////////////////////////////////////////////////////////////////////
+void ComputePipeline::RecordCovariancePass(VkCommandBuffer commandBuffer,
+                                           uint32_t imageIndex) {
+  // Frames still in flight read the old cache, the frame barrier above
+  // already waits for their compute work
+  _profiler.BeginStage(commandBuffer, "covariance");
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    _computePipelines[PipelineType::COVARIANCE]);
 
-  //////////////////////////////////////////////////////////////////////////////////////
-  // End recording
-  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-    throw std::runtime_error("Failed to record command buffer!");
+  struct {
+    uint32_t numGaussians;
+    float scaleModifier;
+  } pushCovariance = {uint32_t(_numGaussians), g_renderSettings.splatScale};
+  vkCmdPushConstants(commandBuffer, _pipelineLayouts[PipelineType::COVARIANCE],
+                     VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushCovariance),
+                     &pushCovariance);
+  vkCmdBindDescriptorSets(
+      commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+      _pipelineLayouts[PipelineType::COVARIANCE], 0, 1,
+      &_descriptorSets[PipelineType::COVARIANCE][imageIndex], 0, nullptr);
+  vkCmdDispatch(commandBuffer, (_numGaussians + 255) / 256, 1, 1);
+
+  VkMemoryBarrier covBarrier = {};
+  covBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  covBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  covBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &covBarrier,
+                       0, nullptr, 0, nullptr);
+  _profiler.EndStage(commandBuffer);
+
+  _covarianceScale = g_renderSettings.splatScale;
+}
+
+void ComputePipeline::RecordDispatchArgs(VkCommandBuffer commandBuffer,
+                                         uint32_t imageIndex,
+                                         bool overBudget) {
+  // Splat budget histogram. The shader returns right away when the keys
+  // fit, direct frames that know they fit skip it altogether
+  if (overBudget) {
+    vkCmdFillBuffer(commandBuffer, _gaussianBuffers.depthHistogram, 0,
+                    VK_WHOLE_SIZE, 0);
+
+    VkMemoryBarrier clearBarrier = {};
+    clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    clearBarrier.dstAccessMask =
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                         &clearBarrier, 0, nullptr, 0, nullptr);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                      _computePipelines[PipelineType::DEPTH_BUDGET]);
+    struct {
+      uint32_t capacity;
+      float nearPlane;
+      float farPlane;
+    } pushBudget = {_sizeBufferMax, g_renderSettings.nearPlane,
+                    g_renderSettings.farPlane};
+    vkCmdPushConstants(commandBuffer,
+                       _pipelineLayouts[PipelineType::DEPTH_BUDGET],
+                       VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushBudget),
+                       &pushBudget);
+    vkCmdBindDescriptorSets(
+        commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+        _pipelineLayouts[PipelineType::DEPTH_BUDGET], 0, 1,
+        &_descriptorSets[PipelineType::DEPTH_BUDGET][imageIndex], 0, nullptr);
+    vkCmdDispatchIndirect(commandBuffer, _gaussianBuffers.visibleArgs,
+                          offsetof(VisibleArgs, visibleDispatch));
+
+    VkMemoryBarrier budgetBarrier = {};
+    budgetBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    budgetBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    budgetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                         &budgetBarrier, 0, nullptr, 0, nullptr);
   }
 
-  /*std::cout << " Command buffer recorded for swapchain image " << imageIndex
-            << std::endl;*/
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    _computePipelines[PipelineType::DISPATCH_ARGS]);
+
+  struct {
+    uint32_t capacity;
+    uint32_t elementsPerWorkgroup;
+  } pushArgs = {_sizeBufferMax, WORKGROUP_SIZE * blocks_per_workgroup};
+  vkCmdPushConstants(commandBuffer,
+                     _pipelineLayouts[PipelineType::DISPATCH_ARGS],
+                     VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushArgs),
+                     &pushArgs);
+  vkCmdBindDescriptorSets(
+      commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+      _pipelineLayouts[PipelineType::DISPATCH_ARGS], 0, 1,
+      &_descriptorSets[PipelineType::DISPATCH_ARGS][imageIndex], 0, nullptr);
+  vkCmdDispatch(commandBuffer, 1, 1, 1);
+
+  VkMemoryBarrier argsBarrier = {};
+  argsBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  argsBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  // idkeys advances keyCursor atomically
+  argsBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT |
+                              VK_ACCESS_SHADER_WRITE_BIT |
+                              VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                           VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                       0, 1, &argsBarrier, 0, nullptr, 0, nullptr);
 }
 
-void ComputePipeline::RecordCommandRender(uint32_t imageIndex, int numRendered,
-                                          Camera &cam) {
-  VkCommandBuffer commandBuffer = _renderCommandBuffers[imageIndex];
+void ComputePipeline::RecordOnesweepSort(VkCommandBuffer commandBuffer,
+                                         uint32_t imageIndex,
+                                         uint32_t radixPasses, bool indirect,
+                                         uint32_t numWorkgroups) {
+  auto &keyPipelines = UseKey32() ? _computePipelines32 : _computePipelines;
+
+  // Histograms, partition counters and lookback flags start at zero. The
+  // lookback region is sized for the buffer capacity, indirect frames only
+  // know their workgroup count on the GPU
+  uint32_t elementsPerWorkgroup = WORKGROUP_SIZE * blocks_per_workgroup;
+  uint32_t capacityWorkgroups =
+      (_sizeBufferMax + elementsPerWorkgroup - 1) / elementsPerWorkgroup;
+  VkDeviceSize clearSize =
+      (ONESWEEP_STATUS_OFFSET +
+       radixPasses * RADIX_SORT_BINS * capacityWorkgroups) *
+      sizeof(uint32_t);
+  vkCmdFillBuffer(commandBuffer, _gaussianBuffers.histogram, 0, clearSize, 0);
+
+  VkMemoryBarrier clearBarrier = {};
+  clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  clearBarrier.dstAccessMask =
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                       &clearBarrier, 0, nullptr, 0, nullptr);
+
+  auto dispatchSort = [&]() {
+    if (indirect)
+      vkCmdDispatchIndirect(commandBuffer, _gaussianBuffers.dispatchArgs,
+                            offsetof(DispatchArgs, sortDispatch));
+    else
+      vkCmdDispatch(commandBuffer, numWorkgroups, 1, 1);
+  };
 
-  // Begin recording
-  VkCommandBufferBeginInfo beginInfo = {};
-  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-  beginInfo.flags = 0; // Not one-time submit
+  struct {
+    uint32_t first;  // g_num_passes / g_shift
+    uint32_t second; // unused / g_pass
+  } pushArgs;
+
+  // GLOBAL HISTOGRAM of every digit, read from wherever pass 0 reads
+  PipelineType histType = (radixPasses % 2 == 0)
+                              ? PipelineType::RADIX_HISTOGRAM_0
+                              : PipelineType::RADIX_HISTOGRAM_1;
+  pushArgs = {radixPasses, 0};
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    keyPipelines[PipelineType::ONESWEEP_HISTOGRAM]);
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          _pipelineLayouts[PipelineType::RADIX_HISTOGRAM_0], 0,
+                          1, &_descriptorSets[histType][imageIndex], 0,
+                          nullptr);
+  vkCmdPushConstants(commandBuffer,
+                     _pipelineLayouts[PipelineType::RADIX_HISTOGRAM_0],
+                     VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushArgs),
+                     &pushArgs);
+  dispatchSort();
 
-  if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
-    throw std::runtime_error("Failed to begin recording command buffer!");
+  VkMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask =
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
+                       nullptr, 0, nullptr);
+
+  // One sweep per digit: a single read and write of keys and values
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    keyPipelines[PipelineType::ONESWEEP_SCATTER]);
+  for (uint32_t pass = 0; pass < radixPasses; pass++) {
+    bool isEven = ((radixPasses - pass) % 2 == 0);
+    PipelineType scatterType = isEven ? PipelineType::RADIX_SCATTER_0
+                                      : PipelineType::RADIX_SCATTER_1;
+    pushArgs = {pass * 8, pass};
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            _pipelineLayouts[PipelineType::RADIX_SCATTER_0], 0,
+                            1, &_descriptorSets[scatterType][imageIndex], 0,
+                            nullptr);
+    vkCmdPushConstants(commandBuffer,
+                       _pipelineLayouts[PipelineType::RADIX_SCATTER_0],
+                       VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushArgs),
+                       &pushArgs);
+    dispatchSort();
+
+    if (pass < radixPasses - 1) {
+      vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                           &barrier, 0, nullptr, 0, nullptr);
+    }
   }
+}
 
-  if (numRendered) {
+void ComputePipeline::RecordRenderPass(VkCommandBuffer commandBuffer,
+                                       uint32_t imageIndex, int numRendered,
+                                       Camera &cam, bool indirect) {
+  // Indirect frames do not know numRendered on the CPU, an empty frame just
+  // dispatches zero workgroups. Direct frames over the sort buffer capacity
+  // go indirect too: only the GPU knows how many keys the budget kept
+  bool overBudget = indirect || uint32_t(numRendered) > _sizeBufferMax;
+  indirect = overBudget;
+  if (indirect || numRendered) {
 
 #ifdef __APPLE__
     TransitionImage(
@@ -483,140 +1304,194 @@ void ComputePipeline::RecordCommandRender(uint32_t imageIndex, int numRendered,
         VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
 #endif
+    _profiler.BeginStage(commandBuffer, "budget");
+    RecordDispatchArgs(commandBuffer, imageIndex, overBudget);
+    _profiler.EndStage(commandBuffer);
+
+    // Key layout is picked per frame: (tileID << depthBits) | depth, sorted
+    // on 32-bit keys when it fits and only over the bits actually used
+    uint32_t depthBits = uint32_t(g_renderSettings.depthKeyBits);
+    uint32_t radixPasses = uint32_t(getRadixIterations());
+    auto &keyPipelines = UseKey32() ? _computePipelines32 : _computePipelines;
+
+    // Each pass ping-pongs keys <-> keysRadix. With an odd pass count idkeys
+    // writes into the radix buffers so the last pass lands in keys/values
+    PipelineType idKeysType = (radixPasses % 2 == 0)
+                                  ? PipelineType::ASSIGN_TILE_IDS
+                                  : PipelineType::ASSIGN_TILE_IDS_1;
+
+    _profiler.BeginStage(commandBuffer, "keys");
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                      _computePipelines[PipelineType::ASSIGN_TILE_IDS]);
+                      keyPipelines[PipelineType::ASSIGN_TILE_IDS]);
 
     VkExtent2D extent = _vkContext.GetSwapchainExtent();
-    uint32_t tileX = (extent.width / _windowResize + 15) / 16;
+    uint32_t tileX =
+        (extent.width / _windowResize + _tileWidth - 1) / _tileWidth;
     struct {
       uint32_t tile;
-      int32_t nGauss;
-      uint32_t culling;
-    } pushCt = {tileX, _numGaussians, 1};
+      uint32_t maxKeys;
+      uint32_t depthBits;
+      float nearPlane;
+      float farPlane;
+      uint32_t exactTiles;
+      uint32_t opacityRadius;
+      uint32_t numTiles;
+    } pushCt = {tileX,
+                _sizeBufferMax,
+                depthBits,
+                g_renderSettings.nearPlane,
+                g_renderSettings.farPlane,
+                uint32_t(g_renderSettings.exactTileTest),
+                uint32_t(g_renderSettings.opacityAwareRadius),
+                getNumTiles()};
     vkCmdPushConstants(commandBuffer,
                        _pipelineLayouts[PipelineType::ASSIGN_TILE_IDS],
                        VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushCt), &pushCt);
 
-    vkCmdBindDescriptorSets(
-        commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-        _pipelineLayouts[PipelineType::ASSIGN_TILE_IDS], 0, 1,
-        &_descriptorSets[PipelineType::ASSIGN_TILE_IDS][imageIndex], 0,
-        nullptr);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            _pipelineLayouts[PipelineType::ASSIGN_TILE_IDS], 0,
+                            1, &_descriptorSets[idKeysType][imageIndex], 0,
+                            nullptr);
 
-    vkCmdDispatch(commandBuffer, (_numGaussians + 255) / 256, 1, 1);
+    // One invocation per visible Gaussian, counted by preprocess
+    vkCmdDispatchIndirect(commandBuffer, _gaussianBuffers.visibleArgs,
+                          offsetof(VisibleArgs, visibleDispatch));
 
     VkMemoryBarrier barrier = {};
     barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
     barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT; // For presentation
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
     vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 1, &barrier,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier,
                          0, nullptr, 0, nullptr);
+    _profiler.EndStage(commandBuffer);
 
     ////////////////////////////////////////////////////////////////////////////////////////
 
-    VkMemoryBarrier barrier_t = {};
-    barrier_t.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-    barrier_t.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-    barrier_t.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT; // For presentation
-
-    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 1, &barrier_t,
-                         0, nullptr, 0, nullptr);
-    uint32_t numElementsToSort = numRendered;
-
     uint32_t elementsPerWorkgroup =
         WORKGROUP_SIZE * blocks_per_workgroup; // 256 * 32 = 8192
     uint32_t numWorkgroups =
-        (numElementsToSort + elementsPerWorkgroup - 1) / elementsPerWorkgroup;
+        (uint32_t(numRendered) + elementsPerWorkgroup - 1) /
+        elementsPerWorkgroup;
 
-    // Prepare push constants
+    // Element and workgroup counts are read from the dispatch args buffer
     struct RadixPushConstants {
-      uint32_t g_num_elements;
       uint32_t g_shift;
-      uint32_t g_num_workgroups;
       uint32_t g_num_blocks_per_workgroup;
     } radixPC;
 
-    radixPC.g_num_elements = numElementsToSort;
-    radixPC.g_num_workgroups = numWorkgroups;
     radixPC.g_num_blocks_per_workgroup = blocks_per_workgroup;
 
-    // Perform 6 passes of radix sort (tiles_ID always can be represented with
-    // 2 bits)
-    for (uint32_t pass = 0; pass < 6; pass++) {
-      radixPC.g_shift = pass * 8;
-
-      bool isEven = (pass % 2 == 0);
-
-      // HISTOGRAM PASS
-      PipelineType histType = isEven ? PipelineType::RADIX_HISTOGRAM_0
-                                     : PipelineType::RADIX_HISTOGRAM_1;
-
-      vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                        _computePipelines[PipelineType::RADIX_HISTOGRAM_0]);
-      vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                              _pipelineLayouts[PipelineType::RADIX_HISTOGRAM_0],
-                              0, 1, &_descriptorSets[histType][imageIndex], 0,
-                              nullptr);
-      vkCmdPushConstants(
-          commandBuffer, _pipelineLayouts[PipelineType::RADIX_HISTOGRAM_0],
-          VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RadixPushConstants), &radixPC);
-      vkCmdDispatch(commandBuffer, numWorkgroups, 1, 1);
-
-      VkMemoryBarrier histBarrier = {};
-      histBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-      histBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-      histBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-      vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
-                           &histBarrier, 0, nullptr, 0, nullptr);
-
-      // SCATTER PASS
-      PipelineType scatterType = isEven ? PipelineType::RADIX_SCATTER_0
-                                        : PipelineType::RADIX_SCATTER_1;
-
-      vkCmdBindPipeline(
-          commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-          _computePipelines[PipelineType::RADIX_SCATTER_0]); // Use same
-                                                             // pipeline
-      vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                              _pipelineLayouts[PipelineType::RADIX_SCATTER_0],
-                              0, 1, &_descriptorSets[scatterType][imageIndex],
-                              0, nullptr);
-      vkCmdPushConstants(
-          commandBuffer, _pipelineLayouts[PipelineType::RADIX_SCATTER_0],
-          VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RadixPushConstants), &radixPC);
-      vkCmdDispatch(commandBuffer, numWorkgroups, 1, 1);
-
-      if (pass < 5) {
-        VkMemoryBarrier scatterBarrier = {};
-        scatterBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-        scatterBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-        scatterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        vkCmdPipelineBarrier(commandBuffer,
-                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+    auto dispatchSort = [&]() {
+      if (indirect)
+        vkCmdDispatchIndirect(commandBuffer, _gaussianBuffers.dispatchArgs,
+                              offsetof(DispatchArgs, sortDispatch));
+      else
+        vkCmdDispatch(commandBuffer, numWorkgroups, 1, 1);
+    };
+
+    _profiler.BeginStage(commandBuffer, "sort");
+    if (g_renderSettings.onesweepSort) {
+      RecordOnesweepSort(commandBuffer, imageIndex, radixPasses, indirect,
+                         numWorkgroups);
+    } else {
+      for (uint32_t pass = 0; pass < radixPasses; pass++) {
+        radixPC.g_shift = pass * 8;
+
+        // _0 sets read keys/values, _1 sets read keysRadix/valuesRadix
+        bool isEven = ((radixPasses - pass) % 2 == 0);
+
+        // HISTOGRAM PASS
+        PipelineType histType = isEven ? PipelineType::RADIX_HISTOGRAM_0
+                                       : PipelineType::RADIX_HISTOGRAM_1;
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          keyPipelines[PipelineType::RADIX_HISTOGRAM_0]);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                _pipelineLayouts[PipelineType::RADIX_HISTOGRAM_0],
+                                0, 1, &_descriptorSets[histType][imageIndex], 0,
+                                nullptr);
+        vkCmdPushConstants(
+            commandBuffer, _pipelineLayouts[PipelineType::RADIX_HISTOGRAM_0],
+            VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RadixPushConstants), &radixPC);
+        dispatchSort();
+
+        VkMemoryBarrier histBarrier = {};
+        histBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        histBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        histBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                             &histBarrier, 0, nullptr, 0, nullptr);
+
+        // SCAN PASS: per-workgroup offsets once, one workgroup per digit.
+        // Same layout, the histogram pass's set and push constants stay bound
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          _computePipelines[PipelineType::RADIX_SCAN]);
+        vkCmdDispatch(commandBuffer, RADIX_SORT_BINS, 1, 1);
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
-                             &scatterBarrier, 0, nullptr, 0, nullptr);
+                             &histBarrier, 0, nullptr, 0, nullptr);
+
+        // SCATTER PASS
+        PipelineType scatterType = isEven ? PipelineType::RADIX_SCATTER_0
+                                          : PipelineType::RADIX_SCATTER_1;
+
+        vkCmdBindPipeline(
+            commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+            keyPipelines[PipelineType::RADIX_SCATTER_0]); // Use same
+                                                               // pipeline
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                _pipelineLayouts[PipelineType::RADIX_SCATTER_0],
+                                0, 1, &_descriptorSets[scatterType][imageIndex],
+                                0, nullptr);
+        vkCmdPushConstants(
+            commandBuffer, _pipelineLayouts[PipelineType::RADIX_SCATTER_0],
+            VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RadixPushConstants), &radixPC);
+        dispatchSort();
+
+        if (pass < radixPasses - 1) {
+          VkMemoryBarrier scatterBarrier = {};
+          scatterBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+          scatterBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+          scatterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+          vkCmdPipelineBarrier(commandBuffer,
+                               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                               &scatterBarrier, 0, nullptr, 0, nullptr);
+        }
       }
     }
 
+    _profiler.EndStage(commandBuffer);
+
+    // Tiles without splats this frame must not keep last frame's ranges.
+    // Only the current tile grid is read, not the whole MIN_TILE_DIM buffer
+    _profiler.BeginStage(commandBuffer, "boundaries");
+    vkCmdFillBuffer(commandBuffer, _gaussianBuffers.ranges, 0,
+                    VkDeviceSize(getNumTiles()) * 2 * sizeof(uint32_t), 0);
+
     VkMemoryBarrier finalSortBarrier = {};
     finalSortBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-    finalSortBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-    finalSortBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+    finalSortBarrier.srcAccessMask =
+        VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    finalSortBarrier.dstAccessMask =
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
                          &finalSortBarrier, 0, nullptr, 0, nullptr);
 
     /////////////////////////////////////////////////////////////////////////////////////////
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                      _computePipelines[PipelineType::TILE_BOUNDARIES]);
+                      keyPipelines[PipelineType::TILE_BOUNDARIES]);
 
+    uint32_t boundariesPC[2] = {depthBits, getNumTiles()};
     vkCmdPushConstants(
         commandBuffer, _pipelineLayouts[PipelineType::TILE_BOUNDARIES],
-        VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &numRendered);
+        VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(boundariesPC), boundariesPC);
 
     // Bind descriptor set
     vkCmdBindDescriptorSets(
@@ -625,7 +1500,11 @@ void ComputePipeline::RecordCommandRender(uint32_t imageIndex, int numRendered,
         &_descriptorSets[PipelineType::TILE_BOUNDARIES][imageIndex], 0,
         nullptr);
 
-    vkCmdDispatch(commandBuffer, (numRendered + 255) / 256, 1, 1);
+    if (indirect)
+      vkCmdDispatchIndirect(commandBuffer, _gaussianBuffers.dispatchArgs,
+                            offsetof(DispatchArgs, boundariesDispatch));
+    else
+      vkCmdDispatch(commandBuffer, (numRendered + 255) / 256, 1, 1);
 
     VkMemoryBarrier tilesBarrier = {};
     tilesBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
@@ -634,11 +1513,24 @@ void ComputePipeline::RecordCommandRender(uint32_t imageIndex, int numRendered,
     vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
                          &tilesBarrier, 0, nullptr, 0, nullptr);
+    _profiler.EndStage(commandBuffer);
 
     ///////////////////////////////////////////////////////////////////////////////////////////
+    _profiler.BeginStage(commandBuffer, "render");
     clearSwapchain(commandBuffer, imageIndex, true);
+    RasterizerMode rasterizer = g_renderSettings.rasterizer;
+    PipelineType renderPipeline = PipelineType::RENDER;
+    if (rasterizer == RasterizerMode::Shared)
+      renderPipeline = PipelineType::RENDER_SHARED;
+    else if (rasterizer == RasterizerMode::SharedSubtile)
+      renderPipeline = PipelineType::RENDER_SHARED_SUBTILE;
+    uint32_t groupWidth = _tileWidth, groupHeight = _tileHeight;
+    if (rasterizer == RasterizerMode::SharedSubtile) {
+      groupWidth /= 2;
+      groupHeight /= 2;
+    }
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                      _computePipelines[PipelineType::RENDER]);
+                      _computePipelines[renderPipeline]);
 
     struct {
       uint32_t w;
@@ -659,8 +1551,13 @@ void ComputePipeline::RecordCommandRender(uint32_t imageIndex, int numRendered,
                             &_descriptorSets[PipelineType::RENDER][imageIndex],
                             0, nullptr);
 
-    vkCmdDispatch(commandBuffer, (extent.width / _windowResize + 15) / 16,
-                  (extent.height / _windowResize + 15) / 16, 1);
+    vkCmdDispatch(commandBuffer,
+                  (extent.width / _windowResize + groupWidth - 1) / groupWidth,
+                  (extent.height / _windowResize + groupHeight - 1) /
+                      groupHeight,
+                  1);
+    _profiler.EndStage(commandBuffer);
+    _rasterTimedMode[_currentFrame] = rasterizer;
     ///////////////////////////////////////////////////////////////////////////////////////
     VkMemoryBarrier barrier_x = {};
     barrier_x.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
@@ -674,6 +1571,7 @@ void ComputePipeline::RecordCommandRender(uint32_t imageIndex, int numRendered,
 /////////////////////////////////////////////////////////////////////////
 // Apple upsampling
 #ifdef __APPLE__
+    _profiler.BeginStage(commandBuffer, "upsample");
     TransitionImage(commandBuffer, VK_IMAGE_LAYOUT_GENERAL,
                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
                     _renderTarget.image, VK_ACCESS_SHADER_WRITE_BIT,
@@ -699,11 +1597,19 @@ void ComputePipeline::RecordCommandRender(uint32_t imageIndex, int numRendered,
     vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
                          VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 1,
                          &barrier_upsample, 0, nullptr, 0, nullptr);
+    _profiler.EndStage(commandBuffer);
 #endif
   } else {
 
     clearSwapchain(commandBuffer, imageIndex);
   }
+
+  // Nothing to overlay or present offscreen
+  if (_vkContext.IsHeadless()) {
+    RecordImageReadback(commandBuffer, imageIndex);
+    return;
+  }
+
   TransitionImage(commandBuffer, VK_IMAGE_LAYOUT_GENERAL,
                   VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
                   _vkContext.GetSwapchainImages()[imageIndex].image,
@@ -732,10 +1638,6 @@ void ComputePipeline::RecordCommandRender(uint32_t imageIndex, int numRendered,
                   VK_ACCESS_MEMORY_READ_BIT,
                   VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
                   VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
-
-  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-    throw std::runtime_error("Failed to record command buffer!");
-  }
 }
 
 VkShaderModule
@@ -787,41 +1689,131 @@ void ComputePipeline::TransitionImage(VkCommandBuffer commandBuffer,
 
 void ComputePipeline::RenderFrame(Camera &cam) {
 
+  // Preprocess, idkeys and render are specialized on the tile size
+  if (uint32_t(g_renderSettings.tileWidth) != _tileWidth ||
+      uint32_t(g_renderSettings.tileHeight) != _tileHeight) {
+    vkDeviceWaitIdle(_vkContext.GetLogicalDevice());
+    RebuildTilePipelines();
+  }
+
+  // Switching paths with frames in flight would mix fences and staging slots
+  if (g_renderSettings.gpuDrivenFrame != _gpuDriven) {
+    vkDeviceWaitIdle(_vkContext.GetLogicalDevice());
+    _gpuDriven = g_renderSettings.gpuDrivenFrame;
+  }
+  if (_gpuDriven) {
+    RenderFrameGpuDriven(cam);
+    return;
+  }
+
   vkWaitForFences(_vkContext.GetLogicalDevice(), 1,
                   &_renderFences[_currentFrame], VK_TRUE, UINT64_MAX);
+  _frameNumber++;
+  ReleaseRetiredBuffers();
+  CollectGpuTimings(_currentFrame);
+  DeliverReadback(_currentFrame);
 
   vkResetFences(_vkContext.GetLogicalDevice(), 1,
                 &_preprocessFences[_currentFrame]);
 
-  uint32_t imageIndex;
-  VkResult result = vkAcquireNextImageKHR(
-      _vkContext.GetLogicalDevice(), _vkContext.GetSwapchain(), UINT64_MAX,
-      _semaphores[_currentFrame], VK_NULL_HANDLE, &imageIndex);
-
-  if (result != VK_SUCCESS) {
-    throw std::runtime_error("Failed to acquire swapchain image!");
-  }
+  uint32_t imageIndex = AcquireImage();
 
   vkResetCommandBuffer(_commandBuffers[imageIndex], 0);
   vkResetCommandBuffer(_renderCommandBuffers[imageIndex], 0);
   RecordCommandPreprocess(imageIndex);
-  submitCommandBuffer(imageIndex);
+  // Headless frames have no acquire to wait on and no present to signal
+  bool headless = _vkContext.IsHeadless();
+  submitCommandBuffer(_commandBuffers[imageIndex], !headless, false,
+                      imageIndex, _preprocessFences[_currentFrame]);
 
   vkWaitForFences(_vkContext.GetLogicalDevice(), 1,
                   &_preprocessFences[_currentFrame], VK_TRUE, UINT64_MAX);
 
   uint32_t totalRendered = ReadFinalPrefixSum();
   g_renderSettings.numRendered = totalRendered;
+  g_renderSettings.numDropped = ReadDroppedKeys(_currentFrame);
+  UpdateTileStats();
 
-  if (totalRendered > _sizeBufferMax) {
-    resizeBuffers(totalRendered * 1.25f);
+  uint32_t capacity = ChooseSortCapacity(totalRendered);
+  if (capacity != _sizeBufferMax) {
+    resizeBuffers(capacity);
   }
+  RefreshSortDescriptors(imageIndex);
 
   vkResetFences(_vkContext.GetLogicalDevice(), 1,
                 &_renderFences[_currentFrame]);
 
+  // Past the memory cap the splat budget drops the farthest keys on the GPU
   RecordCommandRender(imageIndex, totalRendered, cam);
-  submitCommandBuffer(imageIndex, false);
+  submitCommandBuffer(_renderCommandBuffers[imageIndex], false, !headless,
+                      imageIndex, _renderFences[_currentFrame]);
+  _imageSubmitFrame[imageIndex] = _frameNumber;
+
+  PresentImage(imageIndex);
+  _currentFrame = (_currentFrame + 1) % _renderFences.size();
+}
+
+void ComputePipeline::RenderFrameGpuDriven(Camera &cam) {
+
+  vkWaitForFences(_vkContext.GetLogicalDevice(), 1,
+                  &_renderFences[_currentFrame], VK_TRUE, UINT64_MAX);
+  _frameNumber++;
+  ReleaseRetiredBuffers();
+  CollectGpuTimings(_currentFrame);
+  DeliverReadback(_currentFrame);
+
+  // Overflow check is one frame late: this slot last ran frames_in_flight
+  // frames ago. Until the buffers grow the splat budget drops the farthest
+  // keys that do not fit
+  uint32_t requested = ReadRequestedKeys(_currentFrame);
+  g_renderSettings.numDropped = ReadDroppedKeys(_currentFrame);
+  UpdateTileStats();
+  g_renderSettings.numRendered = requested - g_renderSettings.numDropped;
+
+  // The first frames_in_flight slots have not run yet and read back zero,
+  // they keep the initial capacity
+  bool slotRan = _frameNumber > uint64_t(_renderFences.size());
+  uint32_t capacity = slotRan ? ChooseSortCapacity(requested) : _sizeBufferMax;
+  if (capacity != _sizeBufferMax) {
+    resizeBuffers(capacity);
+  }
+
+  uint32_t imageIndex = AcquireImage();
+
+  vkResetFences(_vkContext.GetLogicalDevice(), 1,
+                &_renderFences[_currentFrame]);
+
+  RefreshSortDescriptors(imageIndex);
+  vkResetCommandBuffer(_renderCommandBuffers[imageIndex], 0);
+  RecordCommandFrame(imageIndex, cam);
+  bool headless = _vkContext.IsHeadless();
+  submitCommandBuffer(_renderCommandBuffers[imageIndex], !headless, !headless,
+                      imageIndex, _renderFences[_currentFrame]);
+  _imageSubmitFrame[imageIndex] = _frameNumber;
+
+  PresentImage(imageIndex);
+  _currentFrame = (_currentFrame + 1) % _renderFences.size();
+}
+
+uint32_t ComputePipeline::AcquireImage() {
+  // Offscreen images follow the frame slot, whose fence was just waited on
+  if (_vkContext.IsHeadless())
+    return _currentFrame;
+
+  uint32_t imageIndex;
+  VkResult result = vkAcquireNextImageKHR(
+      _vkContext.GetLogicalDevice(), _vkContext.GetSwapchain(), UINT64_MAX,
+      _semaphores[_currentFrame], VK_NULL_HANDLE, &imageIndex);
+
+  if (result != VK_SUCCESS) {
+    throw std::runtime_error("Failed to acquire swapchain image!");
+  }
+  return imageIndex;
+}
+
+void ComputePipeline::PresentImage(uint32_t imageIndex) {
+  if (_vkContext.IsHeadless())
+    return;
 
   VkPresentInfoKHR presentInfo = {};
   presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -834,7 +1826,6 @@ void ComputePipeline::RenderFrame(Camera &cam) {
   presentInfo.pImageIndices = &imageIndex;
 
   vkQueuePresentKHR(_vkContext.GetGraphicsQueue(), &presentInfo);
-  _currentFrame = (_currentFrame + 1) % _renderFences.size();
 }
 
 void ComputePipeline::CreateDescriptorPool() {
@@ -878,27 +1869,30 @@ void ComputePipeline::UpdateAllDescriptorSets(const PipelineType pType) {
             << std::endl;
 
   auto &swapchainImages = _vkContext.GetSwapchainImages();
+  for (uint32_t i = 0; i < swapchainImages.size(); i++)
+    UpdateDescriptorSets(pType, i);
+}
 
+void ComputePipeline::UpdateDescriptorSets(const PipelineType pType,
+                                           uint32_t i) {
   for (const auto &descriptor : SHADER_LAYOUTS[pType]) {
-    for (uint32_t i = 0; i < swapchainImages.size(); i++) {
-      if (descriptor.type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE) {
-        VkImageView imageView = swapchainImages[i].imageView;
+    if (descriptor.type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE) {
+      VkImageView imageView = _vkContext.GetSwapchainImages()[i].imageView;
 
 #ifdef __APPLE__
-        if (pType == PipelineType::RENDER)
-          imageView = _renderTarget.view;
+      if (pType == PipelineType::RENDER)
+        imageView = _renderTarget.view;
 #endif
 
-        BindImageToDescriptor(pType, i, imageView, descriptor.binding);
+      BindImageToDescriptor(pType, i, imageView, descriptor.binding);
 
-      } else if (descriptor.type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) {
-        BindSamplerToDescriptor(pType, i, _renderTarget.view,
-                                _renderTarget.sampler, descriptor.binding);
-      } else {
-        BindBufferToDescriptor(pType, descriptor.binding, i,
-                               GetBufferByName(descriptor.name),
-                               descriptor.type);
-      }
+    } else if (descriptor.type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) {
+      BindSamplerToDescriptor(pType, i, _renderTarget.view,
+                              _renderTarget.sampler, descriptor.binding);
+    } else {
+      BindBufferToDescriptor(pType, descriptor.binding, i,
+                             GetBufferByName(descriptor.name),
+                             descriptor.type);
     }
   }
 }
@@ -913,6 +1907,8 @@ VkBuffer ComputePipeline::GetBufferByName(const std::string &bufferName) {
     return _gaussianBuffers.rotations;
   if (bufferName == "opacity")
     return _gaussianBuffers.opacity;
+  if (bufferName == "records")
+    return _gaussianBuffers.records;
   if (bufferName == "sh")
     return _gaussianBuffers.sh;
   if (bufferName == "camUniform")
@@ -944,38 +1940,53 @@ VkBuffer ComputePipeline::GetBufferByName(const std::string &bufferName) {
   if (bufferName == "ranges")
     return _gaussianBuffers.ranges;
   if (bufferName == "prefixResult")
-    return _resultBufferPrefix;
+    return _gaussianBuffers.tilesTouchedPrefixSum;
+  if (bufferName == "prefixBlockSums")
+    return _gaussianBuffers.prefixBlockSums;
   if (bufferName == "histograms")
     return _gaussianBuffers.histogram;
+  if (bufferName == "dispatchArgs")
+    return _gaussianBuffers.dispatchArgs;
+  if (bufferName == "depthHistogram")
+    return _gaussianBuffers.depthHistogram;
+  if (bufferName == "tileStats")
+    return _gaussianBuffers.tileStats;
+  if (bufferName == "visibleIndices")
+    return _gaussianBuffers.visibleIndices;
+  if (bufferName == "visibleArgs")
+    return _gaussianBuffers.visibleArgs;
+  if (bufferName == "covariance3D")
+    return _gaussianBuffers.covariance3D;
+  if (bufferName == "clusters")
+    return _gaussianBuffers.clusters;
+  if (bufferName == "clusterOrder")
+    return _gaussianBuffers.clusterOrder;
+  if (bufferName == "visibleClusters")
+    return _gaussianBuffers.visibleClusters;
 
   throw std::runtime_error("Unknown buffer name: " + bufferName);
 }
 
-void ComputePipeline::submitCommandBuffer(uint32_t imageIndex, bool waitSem) {
+void ComputePipeline::submitCommandBuffer(VkCommandBuffer commandBuffer,
+                                          bool waitAcquire, bool signalRender,
+                                          uint32_t imageIndex, VkFence fence) {
   VkSubmitInfo submitInfo = {};
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO; // Type of submit
   submitInfo.commandBufferCount = 1; // Number of command buffers to submit
+  submitInfo.pCommandBuffers = &commandBuffer;
 
   VkSemaphore waitSemaphores[] = {_semaphores[_currentFrame]};
   VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT};
   VkSemaphore signalSemaphores[] = {_renderSemaphores[imageIndex]};
-  if (waitSem) {
+  if (waitAcquire) {
     submitInfo.waitSemaphoreCount = 1;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
-  } else {
-
+  }
+  if (signalRender) {
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
   }
-  VkFence fence = (waitSem) ? _preprocessFences[_currentFrame]
-                            : _renderFences[_currentFrame];
-
-  VkCommandBuffer *bufferToSubmit = waitSem
-                                        ? &_commandBuffers[imageIndex]
-                                        : &_renderCommandBuffers[imageIndex];
-
-  submitInfo.pCommandBuffers = bufferToSubmit;
 
   if (vkQueueSubmit(_vkContext.GetGraphicsQueue(), // Queue to
                                                    // submit to
@@ -986,37 +1997,78 @@ void ComputePipeline::submitCommandBuffer(uint32_t imageIndex, bool waitSem) {
   }
 }
 
-int ComputePipeline::getRadixIterations() {
+// Tiles of the current tile size, a prefix of the ranges buffer (sized for
+// MIN_TILE_DIM tiles)
+uint32_t ComputePipeline::getNumTiles() {
   VkExtent2D extent = _vkContext.GetSwapchainExtent();
-  uint32_t nTiles = ((extent.width + 15) / 16) * ((extent.height + 15) / 16);
-  uint32_t tileBits = static_cast<uint32_t>(std::ceil(std::log2(nTiles)));
-  uint32_t totalBits = 32 + tileBits;
+  return ((extent.width / _windowResize + _tileWidth - 1) / _tileWidth) *
+         ((extent.height / _windowResize + _tileHeight - 1) / _tileHeight);
+}
+
+// Room for one ID past the last tile, idkeys' sentinel key
+uint32_t ComputePipeline::getTileBits() {
+  uint32_t nTiles = getNumTiles();
+  uint32_t tileBits = 0;
+  while ((1u << tileBits) <= nTiles)
+    tileBits++;
+  return tileBits;
+}
+
+// Sized for the onesweep layout, which also covers the classic per-workgroup
+// histograms (RADIX_SORT_BINS * numWorkgroups)
+VkDeviceSize ComputePipeline::getHistogramSize(uint32_t numWorkgroups) {
+  return (ONESWEEP_STATUS_OFFSET +
+          ONESWEEP_MAX_PASSES * RADIX_SORT_BINS * numWorkgroups) *
+         sizeof(uint32_t);
+}
+
+int ComputePipeline::getRadixIterations() {
+  uint32_t totalBits = getTileBits() + uint32_t(g_renderSettings.depthKeyBits);
   return (totalBits + 7) / 8;
 }
 
-void ComputePipeline::resizeBuffers(float size) {
-  // We could implement memory Pool?
+// Bytes per sort key slot: key + radix key (64-bit) and value + radix value
+const VkDeviceSize SORT_BYTES_PER_KEY =
+    2 * sizeof(int64_t) + 2 * sizeof(int32_t);
+
+const PipelineType SORT_PIPELINES[] = {
+    PipelineType::ASSIGN_TILE_IDS,   PipelineType::ASSIGN_TILE_IDS_1,
+    PipelineType::RADIX_HISTOGRAM_0, PipelineType::RADIX_HISTOGRAM_1,
+    PipelineType::RADIX_SCATTER_0,   PipelineType::RADIX_SCATTER_1,
+    PipelineType::TILE_BOUNDARIES,   PipelineType::RENDER};
+
+void ComputePipeline::resizeBuffers(uint32_t capacity) {
   VkPhysicalDevice physicalDevice = _vkContext.GetPhysicalDevice();
   VkDevice device = _vkContext.GetLogicalDevice();
 
-  _buffManager->DestroyBuffer(device, _gaussianBuffers.valuesRadix);
-  _buffManager->DestroyBuffer(device, _gaussianBuffers.values);
-  _buffManager->DestroyBuffer(device, _gaussianBuffers.keys);
-  _buffManager->DestroyBuffer(device, _gaussianBuffers.keysRadix);
-  _buffManager->DestroyBuffer(device, _gaussianBuffers.histogram);
+  // Frames in flight may still read the old buffers: retire them instead of
+  // waiting for the device
+  RetiredSortBuffers retired;
+  retired.generation = _sortGeneration;
+  retired.lastUseFrame = _frameNumber;
+  for (VkBuffer *buffer :
+       {&_gaussianBuffers.keys, &_gaussianBuffers.keysRadix,
+        &_gaussianBuffers.values, &_gaussianBuffers.valuesRadix,
+        &_gaussianBuffers.histogram}) {
+    if (*buffer != VK_NULL_HANDLE)
+      retired.buffers.push_back(*buffer);
+    *buffer = VK_NULL_HANDLE;
+  }
+  if (!retired.buffers.empty())
+    _retiredSortBuffers.push_back(std::move(retired));
 
-  VkDeviceSize bufferSizeKey = sizeof(int64_t) * int(size);
-  VkDeviceSize bufferSizeValue = sizeof(int32_t) * int(size);
+  VkDeviceSize bufferSizeKey = sizeof(int64_t) * VkDeviceSize(capacity);
+  VkDeviceSize bufferSizeValue = sizeof(int32_t) * VkDeviceSize(capacity);
 
   uint32_t elementsPerWorkgroup =
       WORKGROUP_SIZE * blocks_per_workgroup; // 256 * 32 = 8192
   uint32_t numWorkgroups =
-      (int(size) + elementsPerWorkgroup - 1) / elementsPerWorkgroup;
-  VkDeviceSize histogramSize =
-      RADIX_SORT_BINS * numWorkgroups * sizeof(uint32_t);
+      (capacity + elementsPerWorkgroup - 1) / elementsPerWorkgroup;
+  VkDeviceSize histogramSize = getHistogramSize(numWorkgroups);
 
-  VkBufferUsageFlags usage =
-      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+  VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                             VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 
   _gaussianBuffers.keys =
       _buffManager->CreateBuffer(device, physicalDevice, bufferSizeKey, usage,
@@ -1033,16 +2085,105 @@ void ComputePipeline::resizeBuffers(float size) {
   _gaussianBuffers.histogram =
       _buffManager->CreateBuffer(device, physicalDevice, histogramSize, usage,
                                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-  _sizeBufferMax = uint32_t(size);
-  UpdateAllDescriptorSets(PipelineType::ASSIGN_TILE_IDS);
-  UpdateAllDescriptorSets(PipelineType::RADIX_HISTOGRAM_0);
-  UpdateAllDescriptorSets(PipelineType::RADIX_HISTOGRAM_1);
-  UpdateAllDescriptorSets(PipelineType::RADIX_SCATTER_0);
-  UpdateAllDescriptorSets(PipelineType::RADIX_SCATTER_1);
-  UpdateAllDescriptorSets(PipelineType::TILE_BOUNDARIES);
-  UpdateAllDescriptorSets(PipelineType::RENDER);
+  _sizeBufferMax = capacity;
+  _sortGeneration++;
+  _sortPeakRequested = 0;
+  _sortLowUsageFrames = 0;
 
-  std::cout << "resize Buffers and update Descriptors" << std::endl;
+  std::cout << "Sort buffers resized to " << capacity << " keys" << std::endl;
+}
+
+uint32_t ComputePipeline::SortCapacityCap() {
+  auto stats = GPUMemoryInfo::GetCompleteMemoryStats(
+      _vkContext.GetPhysicalDevice(), _vkContext.GetLogicalDevice());
+  double budget = double(stats.totalMemory) *
+                  std::clamp(g_renderSettings.sortMemoryFraction, 0.0f, 1.0f);
+  double keys = budget / double(SORT_BYTES_PER_KEY);
+  if (keys <= 0.0 || keys >= double(UINT32_MAX))
+    return UINT32_MAX;
+  return std::max(uint32_t(keys), 1u);
+}
+
+uint32_t ComputePipeline::ChooseSortCapacity(uint32_t requested) {
+  float growth = std::max(g_renderSettings.sortGrowthFactor, 1.0f);
+  _sortPeakRequested = std::max(_sortPeakRequested, requested);
+
+  if (requested > _sizeBufferMax) {
+    if (_sizeBufferMax >= _sortCapacityCap)
+      return _sizeBufferMax;
+    double grown = std::min(double(requested) * growth,
+                            double(_sortCapacityCap));
+    if (double(requested) > grown && !_sortCapWarned) {
+      std::cerr << "Sort buffers capped at " << _sortCapacityCap
+                << " keys, dropping " << requested - _sortCapacityCap
+                << " of " << requested << std::endl;
+      _sortCapWarned = true;
+    }
+    return uint32_t(grown);
+  }
+
+  // Shrink only when the peak stayed well below capacity for a while, so a
+  // scene hovering around a boundary does not resize back and forth
+  if (g_renderSettings.sortShrinkFrames <= 0)
+    return _sizeBufferMax;
+  double target = double(_sortPeakRequested) * growth;
+  if (target * growth >= double(_sizeBufferMax)) {
+    _sortLowUsageFrames = 0;
+    _sortPeakRequested = requested;
+    return _sizeBufferMax;
+  }
+  if (++_sortLowUsageFrames < g_renderSettings.sortShrinkFrames)
+    return _sizeBufferMax;
+  return std::max(uint32_t(target), 1u);
+}
+
+void ComputePipeline::RefreshSortDescriptors(uint32_t imageIndex) {
+  uint64_t oldGeneration = _imageSortGeneration[imageIndex];
+  if (oldGeneration == _sortGeneration)
+    return;
+
+  // Safe to rewrite: the last submit of this image has completed
+  for (PipelineType pType : SORT_PIPELINES)
+    UpdateDescriptorSets(pType, imageIndex);
+
+  for (auto &retired : _retiredSortBuffers) {
+    if (retired.generation == oldGeneration)
+      retired.lastUseFrame =
+          std::max(retired.lastUseFrame, _imageSubmitFrame[imageIndex]);
+  }
+  _imageSortGeneration[imageIndex] = _sortGeneration;
+}
+
+void ComputePipeline::ReleaseRetiredBuffers() {
+  if (_retiredSortBuffers.empty())
+    return;
+
+  // The fence just waited on covers every submit up to this frame
+  uint64_t completed =
+      _frameNumber > frames_in_flight ? _frameNumber - frames_in_flight : 0;
+
+  // Images that are not being presented still hold the old sets
+  for (uint32_t i = 0; i < _imageSortGeneration.size(); i++) {
+    if (_imageSortGeneration[i] != _sortGeneration &&
+        _imageSubmitFrame[i] <= completed)
+      RefreshSortDescriptors(i);
+  }
+
+  uint64_t oldestBound =
+      *std::min_element(_imageSortGeneration.begin(),
+                        _imageSortGeneration.end());
+  VkDevice device = _vkContext.GetLogicalDevice();
+  size_t before = _retiredSortBuffers.size();
+  std::erase_if(_retiredSortBuffers, [&](const RetiredSortBuffers &retired) {
+    if (retired.generation >= oldestBound || retired.lastUseFrame > completed)
+      return false;
+    for (VkBuffer buffer : retired.buffers)
+      _buffManager->DestroyBuffer(device, buffer);
+    return true;
+  });
+  // Blocks emptied by the old buffers and not reused by the new ones
+  if (_retiredSortBuffers.size() != before)
+    _buffManager->ReleaseEmptyBlocks(device);
 }
 
 void ComputePipeline::SetUpRadixBuffers() {}
@@ -3,15 +3,21 @@
 
 #include "VulkanContext.h"
 
+#include <algorithm>
+
 int VulkanContext::InitContext() {
   try {
     std::cout << "\nVULKAN CONTEXT:\n" << std::endl;
     CreateInstance();
     SetupDebugMessenger();
-    CreateSurface();
+    if (!IsHeadless())
+      CreateSurface();
     GetPhysicalDeviceInternal();
     CreateLogicalDevice();
-    CreateSwapChain();
+    if (IsHeadless())
+      CreateOffscreenImages();
+    else
+      CreateSwapChain();
     CreateCommandPool();
 
     std::cout << "\nVULKAN CONTEXT INITIALIZED\n" << std::endl;
@@ -29,8 +35,15 @@ void VulkanContext::CleanUp() {
   for (const auto &image : _vcxImages) {
     vkDestroyImageView(_vcxMainDevice.logicalDevice, image.imageView, nullptr);
   }
+  // Swapchain images belong to the swapchain, offscreen ones to us
+  for (size_t i = 0; i < _vcxOffscreenMemory.size(); i++) {
+    vkDestroyImage(_vcxMainDevice.logicalDevice, _vcxImages[i].image, nullptr);
+    vkFreeMemory(_vcxMainDevice.logicalDevice, _vcxOffscreenMemory[i],
+                 nullptr);
+  }
   vkDestroyDevice(_vcxMainDevice.logicalDevice, nullptr);
-  vkDestroySurfaceKHR(_vcxInstance, _vcxSurface, nullptr);
+  if (_vcxSurface != VK_NULL_HANDLE)
+    vkDestroySurfaceKHR(_vcxInstance, _vcxSurface, nullptr);
   vkDestroyInstance(_vcxInstance, nullptr);
 
   std::cout << "Vulkan Context CleanUp complete" << std::endl;
@@ -58,12 +71,13 @@ void VulkanContext::CreateInstance() {
   createInfo.pNext = nullptr;
   createInfo.pApplicationInfo = &appInfo;
 
-  uint32_t extensionCount;
+  uint32_t extensionCount = 0;
   std::vector<const char *> instanceExtensions;
-  const char **glfwExtensions;
+  const char **glfwExtensions = nullptr;
 
-  // instance extensions
-  glfwExtensions = glfwGetRequiredInstanceExtensions(&extensionCount);
+  // instance extensions, none for presenting when headless
+  if (!IsHeadless())
+    glfwExtensions = glfwGetRequiredInstanceExtensions(&extensionCount);
 
   for (size_t k = 0; k < extensionCount; k++) {
     instanceExtensions.push_back(glfwExtensions[k]);
@@ -135,7 +149,7 @@ void VulkanContext::CreateLogicalDevice() {
     }
 
     // Platform-specific extension handling
-    std::vector<const char*> requiredExtensions = deviceExtensions; // Copy your existing extensions
+    std::vector<const char*> requiredExtensions = RequiredDeviceExtensions();
     
 #ifdef __APPLE__
     // On macOS with MoltenVK, check for portability subset
@@ -189,6 +203,60 @@ void VulkanContext::CreateLogicalDevice() {
     std::cout << "---VkLogicalDevice created Successfully---" << std::endl;
 }
 
+void VulkanContext::CreateOffscreenImages() {
+  // Same usage the renderer needs from swapchain images, plus the copy back
+  // to host memory
+  _vcxSwapChainFormat = VK_FORMAT_R8G8B8A8_UNORM;
+  VkDevice device = _vcxMainDevice.logicalDevice;
+
+  for (uint32_t i = 0; i < _vcxOffscreenImageCount; i++) {
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = _vcxSwapChainFormat;
+    imageInfo.extent = {_vcxSwapChainExtent2D.width,
+                        _vcxSwapChainExtent2D.height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT |
+                      VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                      VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    SwapChainImage offscreen = {};
+    if (vkCreateImage(device, &imageInfo, nullptr, &offscreen.image) !=
+        VK_SUCCESS)
+      throw std::runtime_error("Failed creating offscreen image");
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, offscreen.image, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = FindMemoryType(
+        memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkDeviceMemory memory;
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+      throw std::runtime_error("Failed allocating offscreen image memory");
+    vkBindImageMemory(device, offscreen.image, memory, 0);
+
+    offscreen.imageView = CreateImageView(offscreen.image, _vcxSwapChainFormat,
+                                          VK_IMAGE_ASPECT_COLOR_BIT);
+    _vcxImages.push_back(offscreen);
+    _vcxOffscreenMemory.push_back(memory);
+  }
+
+  std::cout << "---" << _vcxOffscreenImageCount << " offscreen images "
+            << _vcxSwapChainExtent2D.width << "x"
+            << _vcxSwapChainExtent2D.height << " created Successfully---"
+            << std::endl;
+}
+
 void VulkanContext::CreateSwapChain() {
 
   // CHoose best swapchainfeature
@@ -316,7 +384,35 @@ void VulkanContext::GetPhysicalDeviceInternal() {
   if (_vcxMainDevice.physicalDevice == VK_NULL_HANDLE) {
     throw std::runtime_error("No suitable physical Device");
   }
+
+  // Sort shaders size their per-subgroup arrays from the narrowest subgroup
+  // the device may run. subgroupSize is only the default: variable width
+  // devices (Intel SIMD8/16/32) can launch narrower ones, and only
+  // VK_EXT_subgroup_size_control reports how narrow
+  VkPhysicalDeviceSubgroupSizeControlPropertiesEXT sizeControlProperties = {};
+  sizeControlProperties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_SIZE_CONTROL_PROPERTIES_EXT;
+  VkPhysicalDeviceSubgroupProperties subgroupProperties = {};
+  subgroupProperties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+  bool sizeControl = HasDeviceExtension(
+      _vcxMainDevice.physicalDevice, VK_EXT_SUBGROUP_SIZE_CONTROL_EXTENSION_NAME);
+  if (sizeControl)
+    subgroupProperties.pNext = &sizeControlProperties;
+  VkPhysicalDeviceProperties2 properties = {};
+  properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  properties.pNext = &subgroupProperties;
+  vkGetPhysicalDeviceProperties2(_vcxMainDevice.physicalDevice, &properties);
+  _vcxSubgroupSize = subgroupProperties.subgroupSize;
+  // Without the extension any width down to 1 is allowed
+  _vcxMinSubgroupSize =
+      sizeControl ? std::min(sizeControlProperties.minSubgroupSize,
+                             _vcxSubgroupSize)
+                  : 1;
+
   std::cout << "---VkPhysicalDevice found Successfully---" << std::endl;
+  std::cout << "Subgroup size: " << _vcxSubgroupSize
+            << " (min " << _vcxMinSubgroupSize << ")" << std::endl;
 }
 
 QueueFamilyIndices VulkanContext::GetQueueFamilies(VkPhysicalDevice device) {
@@ -332,6 +428,14 @@ QueueFamilyIndices VulkanContext::GetQueueFamilies(VkPhysicalDevice device) {
     if (queue.queueCount > 0 && queue.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
       queueFamily.graphicsFamily = i;
     }
+    // Nothing is presented headless, the graphics queue stands in
+    if (IsHeadless()) {
+      queueFamily.presentationFamily = queueFamily.graphicsFamily;
+      if (queueFamily.isValid())
+        break;
+      i++;
+      continue;
+    }
     // check if queue family supports presentation
     VkBool32 presentationSupport = false;
     vkGetPhysicalDeviceSurfaceSupportKHR(device, i, _vcxSurface,
@@ -418,8 +522,8 @@ bool VulkanContext::CheckDeviceSuitable(VkPhysicalDevice device) {
   bool deviceExtensionSupport = CheckDeviceExtensionSupport(device);
 
   //// see if device swapchain/surface has format/presentation modes.
-  bool swapChainValid = false;
-  if (deviceExtensionSupport) {
+  bool swapChainValid = IsHeadless();
+  if (deviceExtensionSupport && !IsHeadless()) {
     SwapChainDetails swapChainDetails = GetSwapChainDetails(device);
     swapChainValid = swapChainDetails.imageFormat.size() > 0 &&
                      swapChainDetails.presentationsMode.size() > 0;
@@ -429,19 +533,34 @@ bool VulkanContext::CheckDeviceSuitable(VkPhysicalDevice device) {
          shaderint64;
 }
 
+bool VulkanContext::HasDeviceExtension(VkPhysicalDevice device,
+                                       const char *name) {
+  uint32_t extensionCount = 0;
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount,
+                                       nullptr);
+  std::vector<VkExtensionProperties> extensionProperties(extensionCount);
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount,
+                                       extensionProperties.data());
+  for (const auto &extension : extensionProperties) {
+    if (strcmp(name, extension.extensionName) == 0)
+      return true;
+  }
+  return false;
+}
+
 bool VulkanContext::CheckDeviceExtensionSupport(VkPhysicalDevice device) {
   uint32_t extensionCount = 0;
   vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount,
                                        nullptr);
 
   if (extensionCount == 0)
-    return false;
+    return RequiredDeviceExtensions().empty();
 
   std::vector<VkExtensionProperties> extensionProperties(extensionCount);
   vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount,
                                        extensionProperties.data());
 
-  for (const auto &neededExtensions : deviceExtensions) {
+  for (const auto &neededExtensions : RequiredDeviceExtensions()) {
     bool hasExtension = false;
     for (const auto &extension : extensionProperties) {
       if (strcmp(neededExtensions, extension.extensionName) == 0) {
@@ -456,6 +575,25 @@ bool VulkanContext::CheckDeviceExtensionSupport(VkPhysicalDevice device) {
   return true;
 }
 
+std::vector<const char *> VulkanContext::RequiredDeviceExtensions() const {
+  if (IsHeadless())
+    return {};
+  return deviceExtensions;
+}
+
+uint32_t VulkanContext::FindMemoryType(uint32_t typeFilter,
+                                       VkMemoryPropertyFlags properties) {
+  VkPhysicalDeviceMemoryProperties memProperties;
+  vkGetPhysicalDeviceMemoryProperties(_vcxMainDevice.physicalDevice,
+                                      &memProperties);
+  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+    if ((typeFilter & (1 << i)) &&
+        (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
+      return i;
+  }
+  throw std::runtime_error("No suitable memory type for offscreen image");
+}
+
 bool VulkanContext::CheckValidationLayerSupport() {
   uint32_t layerCount = 0;
   vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
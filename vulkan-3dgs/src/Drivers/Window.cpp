@@ -13,7 +13,10 @@ void WindowManager::InitWindow() {
   g_renderSettings.height = _h;
 }
 
-void WindowManager::DestroyWindow() { glfwDestroyWindow(_window); }
+void WindowManager::DestroyWindow() {
+  if (_window)
+    glfwDestroyWindow(_window);
+}
 
 bool WindowManager::IsActive() const {
   return _window && !glfwWindowShouldClose(_window);
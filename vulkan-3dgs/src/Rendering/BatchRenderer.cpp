@@ -0,0 +1,208 @@
+// Vulkan 3DGS - Copyright (c) 2025 Alejandro Amat (github.com/AlejandroAmat) -
+// MIT Licensed
+
+#include "BatchRenderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+BatchStats BatchRenderer::Run(const std::vector<BatchView> &views,
+                              const ImageCallback &onImage,
+                              const BatchOptions &options) {
+  BatchStats stats;
+  stats.views = uint32_t(views.size());
+  if (views.empty())
+    return stats;
+  if (!_renderer.IsHeadless())
+    throw std::runtime_error("Batch rendering needs a headless context");
+
+  // No CPU wait between preprocess and render, the next view is recorded
+  // while the GPU still works on the previous one
+  bool gpuDriven = g_renderSettings.gpuDrivenFrame;
+  float nearPlane = g_renderSettings.nearPlane;
+  float farPlane = g_renderSettings.farPlane;
+  g_renderSettings.gpuDrivenFrame = true;
+  g_renderSettings.nearPlane = options.nearPlane;
+  g_renderSettings.farPlane = options.farPlane;
+
+  VkExtent2D extent = _renderer.GetRenderExtent();
+  std::deque<size_t> pending(views.size());
+  std::iota(pending.begin(), pending.end(), size_t(0));
+  std::unordered_map<uint64_t, size_t> inFlight; // frame number -> view
+  std::vector<uint32_t> retries(views.size(), 0);
+
+  _renderer.SetReadbackCallback([&](const ReadbackFrame &frame) {
+    auto it = inFlight.find(frame.frame);
+    if (it == inFlight.end())
+      return;
+    size_t index = it->second;
+    inFlight.erase(it);
+    // Overflow is seen one frame late, the buffers have grown by now
+    if (frame.droppedKeys > 0 && retries[index] < options.maxRetries) {
+      retries[index]++;
+      pending.push_front(index);
+      return;
+    }
+    if (frame.droppedKeys > 0)
+      stats.incomplete++;
+    onImage(index, views[index], frame);
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  do {
+    while (!pending.empty()) {
+      size_t index = pending.front();
+      pending.pop_front();
+      _renderer.RenderView(MakeUniforms(views[index], extent.width,
+                                        extent.height, options.nearPlane,
+                                        options.farPlane));
+      inFlight[_renderer.GetFrameNumber()] = index;
+      stats.frames++;
+    }
+    // The last frames_in_flight views, and whatever they send back to retry
+    _renderer.FlushReadbacks();
+  } while (!pending.empty());
+  stats.seconds = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+
+  _renderer.SetReadbackCallback(nullptr);
+  g_renderSettings.gpuDrivenFrame = gpuDriven;
+  g_renderSettings.nearPlane = nearPlane;
+  g_renderSettings.farPlane = farPlane;
+  return stats;
+}
+
+CameraUniforms BatchRenderer::MakeUniforms(const BatchView &view,
+                                           uint32_t width, uint32_t height,
+                                           float nearPlane, float farPlane) {
+  float sx = float(width) / float(view.width);
+  float sy = float(height) / float(view.height);
+  float fx = view.fx * sx, fy = view.fy * sy;
+  float cx = view.cx * sx, cy = view.cy * sy;
+
+  // The renderer's view space looks down -z (see inFrustum in
+  // preprocess.comp) with the same x and y as the COLMAP camera
+  glm::mat4 worldToCamera(view.rotation);
+  worldToCamera[3] = glm::vec4(view.translation, 1.0f);
+  glm::mat4 flipZ = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, 1.0f, -1.0f));
+
+  // Off-center perspective. ndc = 2 u / size - 1, which ndc2Pix turns into
+  // the pixel whose center is at COLMAP coordinate u
+  glm::mat4 proj(0.0f);
+  proj[0][0] = 2.0f * fx / float(width);
+  proj[1][1] = 2.0f * fy / float(height);
+  proj[2][0] = 1.0f - 2.0f * cx / float(width);
+  proj[2][1] = 1.0f - 2.0f * cy / float(height);
+  proj[2][2] = -(farPlane + nearPlane) / (farPlane - nearPlane);
+  proj[2][3] = -1.0f;
+  proj[3][2] = -2.0f * farPlane * nearPlane / (farPlane - nearPlane);
+
+  CameraUniforms uniforms = {};
+  uniforms.viewMatrix = flipZ * worldToCamera;
+  uniforms.projMatrix = proj;
+  uniforms.camPos = glm::vec4(
+      -glm::transpose(view.rotation) * view.translation, 1.0f);
+  uniforms.focal_x = fx;
+  uniforms.focal_y = fy;
+  uniforms.tan_fovx = 0.5f * float(width) / fx;
+  uniforms.tan_fovy = 0.5f * float(height) / fy;
+  uniforms.imageWidth = int(width);
+  uniforms.imageHeight = int(height);
+  return uniforms;
+}
+
+std::vector<BatchView>
+BatchRenderer::LoadColmapViews(const std::string &modelDir) {
+  struct Intrinsics {
+    uint32_t width, height;
+    float fx, fy, cx, cy;
+  };
+
+  std::ifstream cameras(modelDir + "/cameras.txt");
+  if (!cameras)
+    throw std::runtime_error("Cannot open " + modelDir + "/cameras.txt");
+
+  std::map<uint32_t, Intrinsics> intrinsics;
+  bool distorted = false;
+  std::string line;
+  while (std::getline(cameras, line)) {
+    if (line.empty() || line[0] == '#')
+      continue;
+    std::istringstream in(line);
+    uint32_t id;
+    std::string model;
+    Intrinsics cam;
+    in >> id >> model >> cam.width >> cam.height;
+    std::vector<float> params;
+    for (float p; in >> p;)
+      params.push_back(p);
+
+    // Models sharing one focal length start with f cx cy, the rest with
+    // fx fy cx cy. Distortion coefficients follow and are not applied
+    bool singleFocal = model == "SIMPLE_PINHOLE" ||
+                       model == "SIMPLE_RADIAL" || model == "RADIAL";
+    bool twoFocal = model == "PINHOLE" || model == "OPENCV" ||
+                    model == "FULL_OPENCV";
+    if ((!singleFocal && !twoFocal) || params.size() < (singleFocal ? 3 : 4))
+      throw std::runtime_error("Unsupported COLMAP camera model " + model);
+    distorted |= model != "SIMPLE_PINHOLE" && model != "PINHOLE";
+
+    int c = singleFocal ? 1 : 2;
+    cam.fx = params[0];
+    cam.fy = params[c - 1];
+    cam.cx = params[c];
+    cam.cy = params[c + 1];
+    intrinsics[id] = cam;
+  }
+  if (distorted)
+    std::cout << " COLMAP distortion is ignored, undistort the model first"
+              << std::endl;
+
+  std::ifstream images(modelDir + "/images.txt");
+  if (!images)
+    throw std::runtime_error("Cannot open " + modelDir + "/images.txt");
+
+  // Two lines per image, the second (its 2D points, maybe empty) is skipped
+  std::vector<BatchView> views;
+  while (std::getline(images, line)) {
+    if (line.empty() || line[0] == '#')
+      continue;
+    std::istringstream in(line);
+    uint32_t imageId, cameraId;
+    float qw, qx, qy, qz;
+    BatchView view;
+    in >> imageId >> qw >> qx >> qy >> qz >> view.translation.x >>
+        view.translation.y >> view.translation.z >> cameraId >> view.name;
+    std::getline(images, line);
+
+    auto cam = intrinsics.find(cameraId);
+    if (!in || cam == intrinsics.end())
+      throw std::runtime_error("Bad COLMAP image entry " +
+                               std::to_string(imageId));
+    view.rotation = glm::mat3_cast(glm::quat(qw, qx, qy, qz));
+    view.width = cam->second.width;
+    view.height = cam->second.height;
+    view.fx = cam->second.fx;
+    view.fy = cam->second.fy;
+    view.cx = cam->second.cx;
+    view.cy = cam->second.cy;
+    views.push_back(view);
+  }
+
+  // images.txt is in reconstruction order, datasets list views by name
+  std::sort(views.begin(), views.end(),
+            [](const BatchView &a, const BatchView &b) {
+              return a.name < b.name;
+            });
+  std::cout << "Loaded " << views.size() << " COLMAP views from " << modelDir
+            << std::endl;
+  return views;
+}
@@ -3,18 +3,29 @@
 
 #include "BufferManager.h"
 
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
 VkBuffer BufferManager::CreateBuffer(VkDevice device,
                                      VkPhysicalDevice physicalDevice,
                                      VkDeviceSize size,
                                      VkBufferUsageFlags usage,
                                      VkMemoryPropertyFlags properties) {
   VkBuffer buffer;
-  VkDeviceMemory memory;
+  BufferInfo info = {};
 
   CreateBufferInternal(device, physicalDevice, size, usage, properties, buffer,
-                       memory);
+                       info);
 
-  _buffers.push_back({buffer, memory, size});
+  _buffers[buffer] = info;
 
   return buffer;
 }
@@ -49,7 +60,7 @@ VkBuffer BufferManager::CreateVertexBuffer(VkDevice device,
 void BufferManager::CreateBufferInternal(
     VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize size,
     VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-    VkBuffer &buffer, VkDeviceMemory &bufferMemory) {
+    VkBuffer &buffer, BufferInfo &info) {
 
   VkBufferCreateInfo bufferInfo = {};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -62,18 +73,127 @@ void BufferManager::CreateBufferInternal(
 
   VkMemoryRequirements memReq = {};
   vkGetBufferMemoryRequirements(device, buffer, &memReq);
+  uint32_t memoryType =
+      FindMemoryType(physicalDevice, memReq.memoryTypeBits, properties);
+
+  // Staging and uniform memory is small or short lived, so host visible
+  // types use smaller shared blocks
+  VkDeviceSize sharedBlockSize =
+      (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) ? ARENA_HOST_BLOCK_SIZE
+                                                         : ARENA_BLOCK_SIZE;
+  bool dedicated = memReq.size > sharedBlockSize;
+
+  bool placed = false;
+  for (uint32_t i = 0; i < _blocks.size() && !placed && !dedicated; ++i) {
+    if (_blocks[i].memory != VK_NULL_HANDLE && !_blocks[i].dedicated &&
+        _blocks[i].memoryType == memoryType)
+      placed = AllocateRange(i, memReq, info);
+  }
+  if (!placed) {
+    uint32_t block = CreateBlock(device, physicalDevice, memoryType,
+                                 dedicated ? memReq.size : sharedBlockSize);
+    _blocks[block].dedicated = dedicated;
+    placed = AllocateRange(block, memReq, info);
+  }
+  if (!placed)
+    throw std::runtime_error("Failed to sub-allocate buffer memory");
+  info.size = size;
+
+  vkBindBufferMemory(device, buffer, _blocks[info.block].memory,
+                     info.bindOffset);
+}
+
+bool BufferManager::AllocateRange(uint32_t blockIndex,
+                                  const VkMemoryRequirements &memReq,
+                                  BufferInfo &info) {
+  MemoryBlock &block = _blocks[blockIndex];
+  for (auto it = block.freeRanges.begin(); it != block.freeRanges.end();
+       ++it) {
+    VkDeviceSize offset = it->first;
+    VkDeviceSize rangeEnd = it->first + it->second;
+    VkDeviceSize bindOffset = AlignUp(offset, memReq.alignment);
+    if (bindOffset + memReq.size > rangeEnd)
+      continue;
+
+    // Alignment padding stays with the allocation so frees coalesce back
+    // into exactly the range that was taken
+    VkDeviceSize end = bindOffset + memReq.size;
+    block.freeRanges.erase(it);
+    if (end < rangeEnd)
+      block.freeRanges[end] = rangeEnd - end;
+
+    info.block = blockIndex;
+    info.offset = offset;
+    info.rangeSize = end - offset;
+    info.bindOffset = bindOffset;
+    block.used += info.rangeSize;
+    return true;
+  }
+  return false;
+}
+
+uint32_t BufferManager::CreateBlock(VkDevice device,
+                                    VkPhysicalDevice physicalDevice,
+                                    uint32_t memoryType, VkDeviceSize size) {
+  MemoryBlock block;
+  block.memoryType = memoryType;
+  block.size = size;
+  block.freeRanges[0] = size;
 
   VkMemoryAllocateInfo allocInfo = {};
-  allocInfo.allocationSize = memReq.size;
   allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.memoryTypeIndex =
-      FindMemoryType(physicalDevice, memReq.memoryTypeBits, properties);
+  allocInfo.allocationSize = size;
+  allocInfo.memoryTypeIndex = memoryType;
 
-  if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) !=
+  if (vkAllocateMemory(device, &allocInfo, nullptr, &block.memory) !=
       VK_SUCCESS)
     throw std::runtime_error("Failed to allocate VB memory");
 
-  vkBindBufferMemory(device, buffer, bufferMemory, 0);
+  VkPhysicalDeviceMemoryProperties memProperties;
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+  if (memProperties.memoryTypes[memoryType].propertyFlags &
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    vkMapMemory(device, block.memory, 0, VK_WHOLE_SIZE, 0, &block.mapped);
+
+  // Reuse the slot of a released block so indices held by buffers stay valid
+  for (uint32_t i = 0; i < _blocks.size(); ++i) {
+    if (_blocks[i].memory == VK_NULL_HANDLE) {
+      _blocks[i] = std::move(block);
+      return i;
+    }
+  }
+  _blocks.push_back(std::move(block));
+  return uint32_t(_blocks.size() - 1);
+}
+
+void BufferManager::FreeRange(const BufferInfo &info) {
+  MemoryBlock &block = _blocks[info.block];
+  VkDeviceSize offset = info.offset;
+  VkDeviceSize size = info.rangeSize;
+  block.used -= size;
+
+  // Coalesce with the free neighbours on both sides
+  auto next = block.freeRanges.lower_bound(offset);
+  if (next != block.freeRanges.end() && offset + size == next->first) {
+    size += next->second;
+    next = block.freeRanges.erase(next);
+  }
+  if (next != block.freeRanges.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      prev->second += size;
+      return;
+    }
+  }
+  block.freeRanges[offset] = size;
+}
+
+void BufferManager::ReleaseBlock(VkDevice device, uint32_t blockIndex) {
+  MemoryBlock &block = _blocks[blockIndex];
+  if (block.mapped)
+    vkUnmapMemory(device, block.memory);
+  vkFreeMemory(device, block.memory, nullptr);
+  block = MemoryBlock();
 }
 
 uint32_t BufferManager::FindMemoryType(VkPhysicalDevice physicalDevice,
@@ -95,7 +215,8 @@ uint32_t BufferManager::FindMemoryType(VkPhysicalDevice physicalDevice,
 void BufferManager::copyBuffer(VkDevice device, VkDeviceSize deviceSize,
                                VkBuffer srcBuffer, VkBuffer dstBuffer,
                                VkCommandPool commandPool,
-                               VkQueue commandQueue) {
+                               VkQueue commandQueue, VkDeviceSize srcOffset,
+                               VkDeviceSize dstOffset) {
 
   VkCommandBuffer commandBuffer;
   VkCommandBufferAllocateInfo allocateInfo = {};
@@ -111,8 +232,8 @@ void BufferManager::copyBuffer(VkDevice device, VkDeviceSize deviceSize,
   beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
   VkBufferCopy copy = {};
-  copy.dstOffset = 0;
-  copy.srcOffset = 0;
+  copy.dstOffset = dstOffset;
+  copy.srcOffset = srcOffset;
   copy.size = deviceSize;
 
   vkBeginCommandBuffer(commandBuffer, &beginInfo);
@@ -132,33 +253,69 @@ void BufferManager::copyBuffer(VkDevice device, VkDeviceSize deviceSize,
   vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
 }
 
-VkDeviceMemory BufferManager::GetBufferMemory(VkBuffer buffer) {
-  for (const auto &bufferInfo : _buffers) {
-    if (bufferInfo.buffer == buffer) {
-      return bufferInfo.memory;
-    }
-  }
-  throw std::runtime_error("Buffer memory not found!");
+void *BufferManager::MapBuffer(VkBuffer buffer) {
+  auto it = _buffers.find(buffer);
+  if (it == _buffers.end())
+    throw std::runtime_error("Buffer memory not found!");
+  const MemoryBlock &block = _blocks[it->second.block];
+  if (!block.mapped)
+    throw std::runtime_error("Buffer memory is not host visible!");
+  return static_cast<char *>(block.mapped) + it->second.bindOffset;
 }
 
 void BufferManager::DestroyBuffer(VkDevice device, VkBuffer buffer) {
+  auto it = _buffers.find(buffer);
+  if (it == _buffers.end())
+    return;
 
-  for (auto it = _buffers.begin(); it != _buffers.end(); ++it) {
-    if (it->buffer == buffer) {
-      vkDestroyBuffer(device, it->buffer, nullptr);
-      vkFreeMemory(device, it->memory, nullptr);
-      _buffers.erase(it);
-      return;
-    }
-  }
+  vkDestroyBuffer(device, buffer, nullptr);
+  uint32_t block = it->second.block;
+  FreeRange(it->second);
+  _buffers.erase(it);
+
+  if (_blocks[block].used == 0 && _blocks[block].dedicated)
+    ReleaseBlock(device, block);
 }
 
 void BufferManager::CleanupAllBuffers(VkDevice device) {
-  for (const auto &bufferInfo : _buffers) {
-    vkDestroyBuffer(device, bufferInfo.buffer, nullptr);
-    vkFreeMemory(device, bufferInfo.memory, nullptr);
-  }
-
+  for (const auto &[buffer, info] : _buffers)
+    vkDestroyBuffer(device, buffer, nullptr);
   _buffers.clear();
+
+  for (uint32_t i = 0; i < _blocks.size(); ++i) {
+    if (_blocks[i].memory != VK_NULL_HANDLE)
+      ReleaseBlock(device, i);
+  }
+  _blocks.clear();
   std::cout << " All buffers cleaned up" << std::endl;
 }
+
+void BufferManager::ReleaseEmptyBlocks(VkDevice device) {
+  for (uint32_t i = 0; i < _blocks.size(); ++i) {
+    if (_blocks[i].memory != VK_NULL_HANDLE && _blocks[i].used == 0)
+      ReleaseBlock(device, i);
+  }
+  while (!_blocks.empty() && _blocks.back().memory == VK_NULL_HANDLE)
+    _blocks.pop_back();
+}
+
+BufferMemoryStats BufferManager::GetMemoryStats() const {
+  BufferMemoryStats stats;
+  stats.bufferCount = uint32_t(_buffers.size());
+  for (const MemoryBlock &block : _blocks) {
+    if (block.memory == VK_NULL_HANDLE)
+      continue;
+    stats.blockCount++;
+    stats.reservedBytes += block.size;
+    stats.usedBytes += block.used;
+    for (const auto &[offset, size] : block.freeRanges) {
+      stats.freeBytes += size;
+      stats.largestFreeRange = std::max(stats.largestFreeRange, size);
+      stats.freeRanges++;
+    }
+  }
+  if (stats.freeBytes > 0)
+    stats.fragmentation =
+        1.0f - float(stats.largestFreeRange) / float(stats.freeBytes);
+  return stats;
+}
@@ -25,11 +25,17 @@ void GaussianRenderer::LoadGaussianData(
 }
 
 void GaussianRenderer::InitComputePipeline() {
-  _imguiHandler.Init();
+  // UI and axis gizmo draw into the swapchain, there is none headless
+  _imguiHandler.setBufferManager(&_bufferManager);
   _graphcsPipeline.setBufferManager(&_bufferManager);
-  _graphcsPipeline.Init();
+  if (!_vulkanContext.IsHeadless()) {
+    _imguiHandler.Init();
+    _graphcsPipeline.Init();
+  }
   _computePipeline.setNumGaussians(_nGauss);
   g_renderSettings.numGaussians = _nGauss;
+  g_renderSettings.numClusters =
+      (_nGauss + GAUSSIAN_CLUSTER_SIZE - 1) / GAUSSIAN_CLUSTER_SIZE;
   _computePipeline.Initialize(_buffers);
 }
 
@@ -43,6 +49,12 @@ void GaussianRenderer::CreateBuffers() {
 
 void GaussianRenderer::Render() { _computePipeline.RenderFrame(*_camera); }
 
+void GaussianRenderer::RenderView(CameraUniforms uniforms) {
+  uniforms.shDegree = _shDegree;
+  _computePipeline.SetCameraUniforms(uniforms);
+  _computePipeline.RenderFrame(*_camera);
+}
+
 void GaussianRenderer::InitializeCamera(float windowWidth, float windowHeight) {
   float aspectRatio = windowWidth / windowHeight;
   _camera = std::make_shared<Camera>(int(windowWidth), int(windowHeight), 45.0f,
@@ -58,13 +70,15 @@ void GaussianRenderer::InitializeCamera(float windowWidth, float windowHeight) {
   g_renderSettings.farPlane = 45.0f;
   g_renderSettings.enableCulling = true;
 
-  glfwSetWindowUserPointer(_vulkanContext.getWindow(), this);
-  // Set up mouse callback
-  glfwSetCursorPosCallback(_vulkanContext.getWindow(), mouse_callback);
+  if (!_vulkanContext.IsHeadless()) {
+    glfwSetWindowUserPointer(_vulkanContext.getWindow(), this);
+    // Set up mouse callback
+    glfwSetCursorPosCallback(_vulkanContext.getWindow(), mouse_callback);
 
-  // Capture mouse cursor
-  glfwSetInputMode(_vulkanContext.getWindow(), GLFW_CURSOR,
-                   GLFW_CURSOR_DISABLED);
+    // Capture mouse cursor
+    glfwSetInputMode(_vulkanContext.getWindow(), GLFW_CURSOR,
+                     GLFW_CURSOR_DISABLED);
+  }
   std::cout << "Camera initialized with aspect ratio: " << aspectRatio
             << std::endl;
 }
@@ -134,17 +148,40 @@ void GaussianRenderer::CreateGaussianBuffers() {
                "through staging buffers ---"
             << std::endl;
 
-  CreateAndUploadBuffer<glm::vec4>(_buffers.xyz,
-                                   _gaussianData->GetPositionsData(), "_xyz");
-  CreateAndUploadBuffer<glm::vec4>(_buffers.scales,
-                                   _gaussianData->GetScalesData(), "_scale");
-  CreateAndUploadBuffer<glm::vec4>(_buffers.rotations,
-                                   _gaussianData->GetRotationsData(), "_rot");
-  CreateAndUploadBuffer<float>(_buffers.opacity,
-                               _gaussianData->GetOpacitiesData(), "_opacity");
-  CreateAndUploadBuffer<float>(
-      _buffers.sh, _gaussianData->GetSHData(), "_SH",
-      3 * (_gaussianData->GetSHCoefficientsPerChannel()));
+  if constexpr (GAUSSIAN_LAYOUT == GaussianLayout::Packed) {
+    std::vector<GaussianRecord> records = _gaussianData->PackRecords();
+    CreateAndUploadBuffer<GaussianRecord>(_buffers.records, records.data(),
+                                          "_records");
+  } else {
+    CreateAndUploadBuffer<glm::vec4>(
+        _buffers.xyz, _gaussianData->GetPositionsData(), "_xyz");
+    CreateAndUploadBuffer<glm::vec4>(
+        _buffers.scales, _gaussianData->GetScalesData(), "_scale");
+    CreateAndUploadBuffer<glm::vec4>(
+        _buffers.rotations, _gaussianData->GetRotationsData(), "_rot");
+    CreateAndUploadBuffer<float>(
+        _buffers.opacity, _gaussianData->GetOpacitiesData(), "_opacity");
+  }
+
+  SHStorage shStorage = g_renderSettings.shStorage;
+  uint32_t shStride = SHStorageStride(
+      shStorage, _gaussianData->GetSHCoefficientsPerChannel());
+  if (shStorage == SHStorage::Float32) {
+    CreateAndUploadBuffer<uint32_t>(_buffers.sh, _gaussianData->GetSHData(),
+                                    "_SH", shStride);
+  } else {
+    std::vector<uint32_t> encodedSH = _gaussianData->EncodeSH(shStorage);
+    CreateAndUploadBuffer<uint32_t>(_buffers.sh, encodedSH.data(), "_SH",
+                                    shStride);
+  }
+
+  std::vector<uint32_t> clusterOrder;
+  std::vector<GaussianCluster> clusters;
+  _gaussianData->BuildClusters(clusterOrder, clusters);
+  CreateAndUploadBuffer<uint32_t>(_buffers.clusterOrder, clusterOrder.data(),
+                                  "_clusterOrder");
+  CreateAndUploadBuffer<GaussianCluster>(_buffers.clusters, clusters.data(),
+                                         "_clusters", 1, clusters.size());
 }
 
 void GaussianRenderer::CreatePipelineStorageBuffers() {
@@ -157,21 +194,80 @@ void GaussianRenderer::CreatePipelineStorageBuffers() {
   CreateWriteBuffers<int>(_buffers.tilesTouchedPrefixSum,
                           "tilesTouchedPrefixSum", 1, true);
   CreateWriteBuffers<glm::vec4>(_buffers.boundingBox, "boundingBox");
-  CreateWriteBuffers<uint64_t>(_buffers.keysRadix, "keysRadix", 10, true);
-  CreateWriteBuffers<uint64_t>(_buffers.keys, "keys", 10, true);
-  CreateWriteBuffers<uint32_t>(_buffers.values, "values", 10, true);
-  CreateWriteBuffers<uint32_t>(_buffers.valuesRadix, "valuesRadix", 10, true);
-  CreateWriteBuffers<uint32_t>(_buffers.histogram, "histogram", 10, true);
+  CreateWriteBuffers<uint32_t>(_buffers.visibleIndices, "visibleIndices", 1);
+  CreateWriteBuffers<uint32_t>(
+      _buffers.covariance3D, "covariance3D",
+      g_renderSettings.covStorage == CovarianceStorage::Half ? 4 : 6);
+
+  uint32_t clusters =
+      (_nGauss + GAUSSIAN_CLUSTER_SIZE - 1) / GAUSSIAN_CLUSTER_SIZE;
+  _buffers.visibleClusters = _bufferManager.CreateBuffer(
+      _vulkanContext.GetLogicalDevice(), _vulkanContext.GetPhysicalDevice(),
+      sizeof(uint32_t) * std::max(clusters, 1u),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+  uint32_t prefixBlocks =
+      (_nGauss + PREFIX_SUM_BLOCK_SIZE - 1) / PREFIX_SUM_BLOCK_SIZE;
+  _buffers.prefixBlockSums = _bufferManager.CreateBuffer(
+      _vulkanContext.GetLogicalDevice(), _vulkanContext.GetPhysicalDevice(),
+      sizeof(uint32_t) * std::max(prefixBlocks, 1u),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+  CreateWriteBuffers<uint64_t>(_buffers.keysRadix, "keysRadix",
+                               INITIAL_KEYS_PER_GAUSSIAN, true);
+  CreateWriteBuffers<uint64_t>(_buffers.keys, "keys",
+                               INITIAL_KEYS_PER_GAUSSIAN, true);
+  CreateWriteBuffers<uint32_t>(_buffers.values, "values",
+                               INITIAL_KEYS_PER_GAUSSIAN, true);
+  CreateWriteBuffers<uint32_t>(_buffers.valuesRadix, "valuesRadix",
+                               INITIAL_KEYS_PER_GAUSSIAN, true);
+  // Same layout as the resized buffers: the onesweep clear covers the
+  // global histograms and counters even before the first resize
+  uint32_t sortWorkgroups =
+      (_nGauss * INITIAL_KEYS_PER_GAUSSIAN + WORKGROUP_SIZE * blocks_per_workgroup - 1) /
+      (WORKGROUP_SIZE * blocks_per_workgroup);
+  _buffers.histogram = _bufferManager.CreateBuffer(
+      _vulkanContext.GetLogicalDevice(), _vulkanContext.GetPhysicalDevice(),
+      ComputePipeline::getHistogramSize(sortWorkgroups),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+          VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
   CreateRangesBuffer();
+
+  _buffers.dispatchArgs = _bufferManager.CreateBuffer(
+      _vulkanContext.GetLogicalDevice(), _vulkanContext.GetPhysicalDevice(),
+      sizeof(DispatchArgs),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+  _buffers.depthHistogram = _bufferManager.CreateBuffer(
+      _vulkanContext.GetLogicalDevice(), _vulkanContext.GetPhysicalDevice(),
+      sizeof(uint32_t) * DEPTH_BUDGET_BUCKETS,
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+  _buffers.tileStats = _bufferManager.CreateBuffer(
+      _vulkanContext.GetLogicalDevice(), _vulkanContext.GetPhysicalDevice(),
+      sizeof(TileStats),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+          VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+  _buffers.visibleArgs = _bufferManager.CreateBuffer(
+      _vulkanContext.GetLogicalDevice(), _vulkanContext.GetPhysicalDevice(),
+      sizeof(VisibleArgs),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+          VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 }
 void GaussianRenderer::UpdateCameraUniforms() {
   CameraUniforms uniforms = _camera->getUniforms();
   uniforms.shDegree = _shDegree;
 
-  CameraUniforms *gpuData = (CameraUniforms *)_cameraUniformMapped;
-
-  // Write to GPU
-  memcpy(_cameraUniformMapped, &uniforms, sizeof(uniforms));
+  // Recorded into the frame's command buffer (vkCmdUpdateBuffer) so frames
+  // in flight never see the uniforms change under them
+  _computePipeline.SetCameraUniforms(uniforms);
 }
 
 void GaussianRenderer::CreateUniformBuffer() {
@@ -185,11 +281,10 @@ void GaussianRenderer::CreateUniformBuffer() {
   std::cout << " Creating uniform buffer : " << bufferSize << " bytes "
             << std::endl;
 
-  _buffers.camUniform =
-      _bufferManager.CreateUniformBuffer(device, physicalDevice, bufferSize);
-
-  VkDeviceMemory mem = _bufferManager.GetBufferMemory(_buffers.camUniform);
-  vkMapMemory(device, mem, 0, bufferSize, 0, &_cameraUniformMapped);
+  _buffers.camUniform = _bufferManager.CreateBuffer(
+      device, physicalDevice, bufferSize,
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
   UpdateCameraUniforms();
 }
@@ -206,9 +301,10 @@ void GaussianRenderer::CreateCopyStagingBuffer() {
       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
           VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-  vkMapMemory(device,
-              _bufferManager.GetBufferMemory(_buffers.numRendered.staging), 0,
-              bufferSize, 0, &_buffers.numRendered.mem);
+  _buffers.numRendered.mem =
+      _bufferManager.MapBuffer(_buffers.numRendered.staging);
+  // GPU driven frames read their slots before anything has been copied
+  memset(_buffers.numRendered.mem, 0, bufferSize);
 }
 
 void GaussianRenderer::CreateRangesBuffer() {
@@ -217,12 +313,14 @@ void GaussianRenderer::CreateRangesBuffer() {
 #ifdef __APPLE__
   windowResize = 2;
 #endif
-  int tiles = (ext.width / windowResize + 15) / 16 *
-              (ext.height / windowResize + 15) / 16;
+  // Smallest tile size, any other fits in the same buffer
+  int tiles = (ext.width / windowResize + MIN_TILE_DIM - 1) / MIN_TILE_DIM *
+              ((ext.height / windowResize + MIN_TILE_DIM - 1) / MIN_TILE_DIM);
 
   _buffers.ranges = _bufferManager.CreateBuffer(
       _vulkanContext.GetLogicalDevice(), _vulkanContext.GetPhysicalDevice(),
       sizeof(glm::vec2) * tiles,
-      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+          VK_BUFFER_USAGE_TRANSFER_DST_BIT,
       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 }
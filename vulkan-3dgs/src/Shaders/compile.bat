@@ -7,6 +7,7 @@ echo Compiling shaders for Windows...
 REM Compile all shaders with correct SPIR-V versions (hardcoded paths)
 glslangValidator.exe -V --target-env spirv1.3 ../Shaders/debug.comp -o ../Shaders/debug.spv
 glslangValidator.exe -V --target-env spirv1.3 ../Shaders/preprocess.comp -o ../Shaders/preprocess.spv
+glslangValidator.exe -V --target-env spirv1.3 -DPACKED_GAUSSIAN_LAYOUT ../Shaders/preprocess.comp -o ../Shaders/preprocess_packed.spv
 glslangValidator.exe -V --target-env spirv1.3 ../Shaders/debugGaussians.comp -o ../Shaders/nearest.spv
 glslangValidator.exe -V --target-env spirv1.3 ../Shaders/prefixsum.comp -o ../Shaders/sum.spv
 glslangValidator.exe -V --target-env spirv1.5 ../Shaders/radix_sort/radixsort.comp -o ../Shaders/sort.spv
@@ -5,6 +5,7 @@ echo "Compiling shaders for macOS (with Apple/MoltenVK compatibility)..."
 # Compile standard shaders (corrected paths for root Shaders folder)
 glslangValidator -V --target-env spirv1.3 ../../Shaders/debug.comp -o ../../Shaders/debug.spv
 glslangValidator -V --target-env spirv1.3 ../../Shaders/preprocess.comp -o ../../Shaders/preprocess.spv
+glslangValidator -V --target-env spirv1.3 -DPACKED_GAUSSIAN_LAYOUT ../../Shaders/preprocess.comp -o ../../Shaders/preprocess_packed.spv
 glslangValidator -V --target-env spirv1.3 ../../Shaders/debugGaussians.comp -o ../../Shaders/nearest.spv
 glslangValidator -V --target-env spirv1.3 ../../Shaders/prefixsum.comp -o ../../Shaders/sum.spv
 glslangValidator -V --target-env spirv1.5 ../../Shaders/idkeys.comp -o ../../Shaders/idkeys.spv
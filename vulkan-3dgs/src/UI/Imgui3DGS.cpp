@@ -209,6 +209,25 @@ void ImguiUI::CreateUI(Camera &cam) {
     ImGui::Separator();
     ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
     ImGui::Text("Frame Time: %.3f ms", 1000.0f / ImGui::GetIO().Framerate);
+
+    if (_profiler && _profiler->IsSupported() &&
+        ImGui::TreeNode("GPU Stages")) {
+      auto stats = _profiler->GetStats();
+      float total = 0.0f;
+      ImGui::TextDisabled("%-11s %7s %7s %7s", "ms", "min", "avg", "p99");
+      for (const auto &stage : stats) {
+        ImGui::Text("%-11s %7.3f %7.3f %7.3f", stage.name.c_str(),
+                    stage.minMs, stage.avgMs, stage.p99Ms);
+        total += stage.avgMs;
+      }
+      ImGui::Text("%-11s %23.3f", "total", total);
+      if (ImGui::Button("Export Trace"))
+        _profiler->ExportChromeTrace("gpu_trace.json");
+      if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Writes gpu_trace.json for chrome://tracing or "
+                          "Perfetto.");
+      ImGui::TreePop();
+    }
     ImGui::Spacing();
 
     ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "GPU Memory");
@@ -242,6 +261,16 @@ void ImguiUI::CreateUI(Camera &cam) {
     } else {
       ImGui::Text("(Detailed usage info not available)");
     }
+
+    if (_bufferManager) {
+      BufferMemoryStats arena = _bufferManager->GetMemoryStats();
+      ImGui::Text("Buffer Arena: %s in %u blocks, %u buffers",
+                  GPUMemoryInfo::FormatBytes(arena.reservedBytes).c_str(),
+                  arena.blockCount, arena.bufferCount);
+      ImGui::Text("Arena Free: %s in %u ranges, %.1f%% fragmented",
+                  GPUMemoryInfo::FormatBytes(arena.freeBytes).c_str(),
+                  arena.freeRanges, arena.fragmentation * 100.0f);
+    }
   }
   ImGui::Spacing();
 
@@ -257,6 +286,22 @@ void ImguiUI::CreateUI(Camera &cam) {
                 g_renderSettings.height * resize);
     ImGui::Text("Number of Gaussians: %d", g_renderSettings.numGaussians);
     ImGui::Text("Number of Rendered Splats: %d", g_renderSettings.numRendered);
+    ImGui::Text("Visible Clusters: %d / %u", g_renderSettings.visibleClusters,
+                g_renderSettings.numClusters);
+    float preprocessed = g_renderSettings.numGaussians
+                             ? 100.0f * g_renderSettings.clusterGaussians /
+                                   g_renderSettings.numGaussians
+                             : 0.0f;
+    ImGui::Text("Preprocessed Gaussians: %d (%.1f%%)",
+                g_renderSettings.clusterGaussians, preprocessed);
+    if (g_renderSettings.numDropped > 0)
+      ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f),
+                         "Splat Budget: %d far keys dropped",
+                         g_renderSettings.numDropped);
+    ImGui::Text("SH Storage: %s",
+                SH_STORAGE_NAMES[int(g_renderSettings.shStorage)]);
+    ImGui::Text("Covariance Cache: %s",
+                COV_STORAGE_NAMES[int(g_renderSettings.covStorage)]);
 
     ImGui::Spacing();
   }
@@ -296,13 +341,124 @@ void ImguiUI::CreateUI(Camera &cam) {
                      "%.1f");
   ImGui::SliderFloat("Far Plane", &g_renderSettings.farPlane, 1.0f, 300.0f,
                      "%.1f");
+  ImGui::Checkbox("Cluster Culling", &g_renderSettings.clusterCulling);
   ImGui::EndDisabled();
   ImGui::PopItemWidth();
   ImGui::Separator();
+  ImGui::Checkbox("GPU-Driven Frame", &g_renderSettings.gpuDrivenFrame);
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Single submit with indirect sort dispatches, no CPU "
+                      "readback. Buffer growth is detected one frame late.");
+  {
+    const char *depthKeyItems[] = {"16 bits", "20 bits", "32 bits (exact)"};
+    const int depthKeyBits[] = {16, 20, 32};
+    int current = g_renderSettings.depthKeyBits == 16   ? 0
+                  : g_renderSettings.depthKeyBits == 20 ? 1
+                                                        : 2;
+    ImGui::PushItemWidth(120);
+    if (ImGui::Combo("Depth Sort Key", &current, depthKeyItems,
+                     IM_ARRAYSIZE(depthKeyItems)))
+      g_renderSettings.depthKeyBits = depthKeyBits[current];
+    ImGui::PopItemWidth();
+    if (ImGui::IsItemHovered())
+      ImGui::SetTooltip("Quantized depth between near and far plane. Fewer "
+                        "bits means fewer radix passes and 32-bit keys.");
+  }
+  ImGui::Checkbox("Onesweep Sort", &g_renderSettings.onesweepSort);
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("One global histogram pass and a single sweep per "
+                      "digit. A workgroup that waits too long on an earlier "
+                      "one counts its keys itself.");
+  ImGui::PushItemWidth(120);
+  ImGui::SliderFloat("Sort Growth", &g_renderSettings.sortGrowthFactor, 1.0f,
+                     3.0f, "%.2fx");
+  ImGui::SliderInt("Shrink After", &g_renderSettings.sortShrinkFrames, 0, 1000,
+                   "%d frames");
+  ImGui::PopItemWidth();
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Sort buffers shrink once the key count stays this "
+                      "many frames below capacity. 0 never shrinks.");
+  ImGui::Separator();
+  {
+    int current = 0;
+    for (int i = 0; i < IM_ARRAYSIZE(TILE_SIZE_NAMES); i++) {
+      if (TILE_SIZE_PRESETS[i][0] == g_renderSettings.tileWidth &&
+          TILE_SIZE_PRESETS[i][1] == g_renderSettings.tileHeight)
+        current = i;
+    }
+    ImGui::PushItemWidth(120);
+    if (ImGui::Combo("Tile Size", &current, TILE_SIZE_NAMES,
+                     IM_ARRAYSIZE(TILE_SIZE_NAMES))) {
+      g_renderSettings.tileWidth = TILE_SIZE_PRESETS[current][0];
+      g_renderSettings.tileHeight = TILE_SIZE_PRESETS[current][1];
+    }
+    ImGui::PopItemWidth();
+    if (ImGui::IsItemHovered())
+      ImGui::SetTooltip("Pixels per tile for key emission, sort and raster. "
+                        "Changing it rebuilds the pipelines.");
+  }
   ImGui::BeginDisabled(true);
-  ImGui::SliderInt("TileSize", &g_renderSettings.tileSize, 8, 256);
   ImGui::Button("Size Culling: ACTIVE");
   ImGui::EndDisabled();
+  ImGui::Checkbox("Exact Tile Test", &g_renderSettings.exactTileTest);
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Emit keys only for tiles the splat ellipse reaches "
+                      "instead of every tile in its bounding box.");
+  ImGui::Checkbox("Opacity-Aware Radius", &g_renderSettings.opacityAwareRadius);
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Shrink each splat to where its alpha drops below "
+                      "1/255 (at most 3 sigma), cull fainter splats.");
+  ImGui::Text("Keys / Gaussian: %.2f (box %.2f)",
+              g_renderSettings.keysPerGaussian,
+              g_renderSettings.aabbKeysPerGaussian);
+  ImGui::Checkbox("SH Level of Detail", &g_renderSettings.shLod);
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Shade small or distant splats with fewer SH bands, "
+                      "skipping the loads of the bands they drop.");
+  ImGui::BeginDisabled(!g_renderSettings.shLod);
+  ImGui::PushItemWidth(120);
+  ImGui::SliderFloat("SH Band Radius", &g_renderSettings.shLodRadius, 0.5f,
+                     32.0f, "%.1f px");
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Radius below which only the base color is used. Each "
+                      "doubling adds one band.");
+  ImGui::SliderFloat("SH Distance", &g_renderSettings.shLodDistance, 0.0f,
+                     300.0f, "%.0f");
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Base color only past this depth, 0 disables.");
+  ImGui::PopItemWidth();
+  ImGui::EndDisabled();
+  ImGui::Text("SH Degree 0/1/2/3: %d / %d / %d / %d",
+              g_renderSettings.shDegreeGaussians[0],
+              g_renderSettings.shDegreeGaussians[1],
+              g_renderSettings.shDegreeGaussians[2],
+              g_renderSettings.shDegreeGaussians[3]);
+  ImGui::PushItemWidth(120);
+  ImGui::SliderFloat("Splat Scale", &g_renderSettings.splatScale, 0.1f, 2.0f,
+                     "%.2fx");
+  ImGui::PopItemWidth();
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Scales every Gaussian. Changing it rebuilds the "
+                      "cached 3D covariances.");
+  ImGui::Separator();
+  {
+    int current = int(g_renderSettings.rasterizer);
+    ImGui::PushItemWidth(120);
+    if (ImGui::Combo("Rasterizer", &current, RASTERIZER_NAMES,
+                     IM_ARRAYSIZE(RASTERIZER_NAMES)))
+      g_renderSettings.rasterizer = RasterizerMode(current);
+    ImGui::PopItemWidth();
+    if (ImGui::IsItemHovered())
+      ImGui::SetTooltip("Shared variants stage each tile's Gaussians in "
+                        "shared memory and stop once every pixel is opaque.");
+    for (int i = 0; i < IM_ARRAYSIZE(RASTERIZER_NAMES); i++) {
+      if (g_renderSettings.rasterTimeMs[i] > 0.0f)
+        ImGui::Text("  %-16s %.3f ms", RASTERIZER_NAMES[i],
+                    g_renderSettings.rasterTimeMs[i]);
+      else
+        ImGui::TextDisabled("  %-16s -", RASTERIZER_NAMES[i]);
+    }
+  }
   ImGui::Separator();
   ImGui::Checkbox("Wireframe Mode", &g_renderSettings.showWireframe);
   ImGui::BeginDisabled(!g_renderSettings.showWireframe);
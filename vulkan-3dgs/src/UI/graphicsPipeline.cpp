@@ -190,13 +190,8 @@ void GraphicsPipeline::CreateVertexBuffer() {
       _vkContext.GetLogicalDevice(), _vkContext.GetPhysicalDevice(),
       bufferSize);
 
-  void *data;
-  vkMapMemory(_vkContext.GetLogicalDevice(),
-              _bufferManager->GetBufferMemory(_vertexBuffer), 0, bufferSize, 0,
-              &data);
+  void *data = _bufferManager->MapBuffer(_vertexBuffer);
   memcpy(data, _axisVertices.data(), (size_t)bufferSize);
-  vkUnmapMemory(_vkContext.GetLogicalDevice(),
-                _bufferManager->GetBufferMemory(_vertexBuffer));
 }
 
 void GraphicsPipeline::CreateGraphicsPipeline() {
@@ -411,13 +406,8 @@ void GraphicsPipeline::UpdateUniformBuffer(uint32_t imageIndex,
   AxisUBO ubo = {};
   ubo.mvp = mvpMatrix;
 
-  void *data;
-  vkMapMemory(_vkContext.GetLogicalDevice(),
-              _bufferManager->GetBufferMemory(_uniformBuffers[imageIndex]), 0,
-              sizeof(ubo), 0, &data);
+  void *data = _bufferManager->MapBuffer(_uniformBuffers[imageIndex]);
   memcpy(data, &ubo, sizeof(ubo));
-  vkUnmapMemory(_vkContext.GetLogicalDevice(),
-                _bufferManager->GetBufferMemory(_uniformBuffers[imageIndex]));
 }
 
 VkShaderModule
@@ -441,14 +431,11 @@ void GraphicsPipeline::CleanUp() {
 
   // Clean up uniform buffers
   for (size_t i = 0; i < _uniformBuffers.size(); i++) {
-    vkDestroyBuffer(device, _uniformBuffers[i], nullptr);
-    vkFreeMemory(device, _bufferManager->GetBufferMemory(_uniformBuffers[i]),
-                 nullptr);
+    _bufferManager->DestroyBuffer(device, _uniformBuffers[i]);
   }
 
   // Clean up vertex buffer
-  vkDestroyBuffer(device, _vertexBuffer, nullptr);
-  vkFreeMemory(device, _bufferManager->GetBufferMemory(_vertexBuffer), nullptr);
+  _bufferManager->DestroyBuffer(device, _vertexBuffer);
 
   // Clean up pipeline
   vkDestroyPipeline(device, _graphicsPipeline, nullptr);
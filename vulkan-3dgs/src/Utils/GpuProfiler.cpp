@@ -0,0 +1,205 @@
+// Vulkan 3DGS - Copyright (c) 2025 Alejandro Amat (github.com/AlejandroAmat) -
+// MIT Licensed
+
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+void GpuProfiler::Init(VkPhysicalDevice physicalDevice, VkDevice device,
+                       uint32_t queueFamily, uint32_t frameSlots) {
+  _device = device;
+  _slots.assign(frameSlots, {});
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+  uint32_t familyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount,
+                                           nullptr);
+  std::vector<VkQueueFamilyProperties> families(familyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount,
+                                           families.data());
+  uint32_t validBits = families[queueFamily].timestampValidBits;
+  if (validBits == 0 || properties.limits.timestampPeriod == 0.0f) {
+    std::cout << " Timestamps not supported, GPU profiler disabled"
+              << std::endl;
+    return;
+  }
+
+  VkQueryPoolCreateInfo poolInfo = {};
+  poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  poolInfo.queryCount = 2 * MAX_STAGES * frameSlots;
+  if (vkCreateQueryPool(device, &poolInfo, nullptr, &_queryPool) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("Failed to create timestamp query pool!");
+  }
+  _nsPerTick = properties.limits.timestampPeriod;
+  _validMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+}
+
+void GpuProfiler::CleanUp() {
+  if (_queryPool != VK_NULL_HANDLE) {
+    vkDestroyQueryPool(_device, _queryPool, nullptr);
+    _queryPool = VK_NULL_HANDLE;
+  }
+}
+
+void GpuProfiler::BeginFrame(VkCommandBuffer commandBuffer, uint32_t slot) {
+  _recordingSlot = slot;
+  SlotState &state = _slots[slot];
+  state.stages.clear();
+  state.nextQuery = 0;
+  state.open = false;
+  if (!IsSupported())
+    return;
+  vkCmdResetQueryPool(commandBuffer, _queryPool, slot * 2 * MAX_STAGES,
+                      2 * MAX_STAGES);
+}
+
+// Both ends wait for everything recorded before them, so back to back stages
+// split the frame without gaps or overlap
+void GpuProfiler::BeginStage(VkCommandBuffer commandBuffer, const char *name) {
+  SlotState &state = _slots[_recordingSlot];
+  if (!IsSupported() || state.open || state.nextQuery + 2 > 2 * MAX_STAGES)
+    return;
+  uint32_t query = _recordingSlot * 2 * MAX_STAGES + state.nextQuery;
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                      _queryPool, query);
+  state.stages.push_back({name, query});
+  state.nextQuery += 2;
+  state.open = true;
+}
+
+void GpuProfiler::EndStage(VkCommandBuffer commandBuffer) {
+  SlotState &state = _slots[_recordingSlot];
+  if (!state.open)
+    return;
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                      _queryPool, state.stages.back().query + 1);
+  state.open = false;
+}
+
+bool GpuProfiler::Collect(uint32_t slot) {
+  SlotState &state = _slots[slot];
+  if (state.open) { // recorded without its end, drop it
+    state.stages.pop_back();
+    state.nextQuery -= 2;
+    state.open = false;
+  }
+  if (!IsSupported() || state.stages.empty())
+    return false;
+
+  std::vector<uint64_t> ticks(state.nextQuery);
+  VkResult result = vkGetQueryPoolResults(
+      _device, _queryPool, slot * 2 * MAX_STAGES, state.nextQuery,
+      ticks.size() * sizeof(uint64_t), ticks.data(), sizeof(uint64_t),
+      VK_QUERY_RESULT_64_BIT);
+  std::vector<PendingStage> stages = std::move(state.stages);
+  state.stages.clear();
+  state.nextQuery = 0;
+  if (result != VK_SUCCESS)
+    return false;
+
+  uint32_t base = slot * 2 * MAX_STAGES;
+  TraceFrame frame = {_collectedFrames++, {}};
+  _lastFrame.clear();
+  for (const PendingStage &stage : stages) {
+    uint64_t begin = ticks[stage.query - base] & _validMask;
+    uint64_t end = ticks[stage.query - base + 1] & _validMask;
+    uint64_t elapsed = (end - begin) & _validMask;
+    float ms = float(double(elapsed) * _nsPerTick * 1e-6);
+
+    if (!_history.count(stage.name))
+      _stageOrder.push_back(stage.name);
+    std::deque<float> &history = _history[stage.name];
+    history.push_back(ms);
+    if (history.size() > HISTORY)
+      history.pop_front();
+    _lastFrame[stage.name] += ms;
+
+    double beginUs = double(begin) * _nsPerTick * 1e-3;
+    frame.events.push_back(
+        {stage.name, beginUs, beginUs + double(elapsed) * _nsPerTick * 1e-3});
+  }
+  _trace.push_back(std::move(frame));
+  if (_trace.size() > TRACE_FRAMES)
+    _trace.pop_front();
+  return true;
+}
+
+std::vector<GpuProfiler::StageStats> GpuProfiler::GetStats() const {
+  std::vector<StageStats> stats;
+  for (const std::string &name : _stageOrder) {
+    const std::deque<float> &history = _history.at(name);
+    if (history.empty())
+      continue;
+    std::vector<float> sorted(history.begin(), history.end());
+    std::sort(sorted.begin(), sorted.end());
+
+    StageStats stage;
+    stage.name = name;
+    stage.lastMs = history.back();
+    stage.minMs = sorted.front();
+    float sum = 0.0f;
+    for (float ms : sorted)
+      sum += ms;
+    stage.avgMs = sum / float(sorted.size());
+    size_t p99 = (sorted.size() * 99 + 99) / 100; // ceil, 1-based
+    stage.p99Ms = sorted[std::min(sorted.size(), p99) - 1];
+    stage.samples = uint32_t(sorted.size());
+    stats.push_back(stage);
+  }
+  return stats;
+}
+
+float GpuProfiler::LastStageMs(const std::string &name) const {
+  auto it = _lastFrame.find(name);
+  return it == _lastFrame.end() ? -1.0f : it->second;
+}
+
+void GpuProfiler::ResetStats() {
+  _stageOrder.clear();
+  _history.clear();
+  _lastFrame.clear();
+  _trace.clear();
+}
+
+bool GpuProfiler::ExportChromeTrace(const std::string &path) const {
+  std::ofstream file(path);
+  if (!file) {
+    std::cerr << "Cannot write GPU trace to " << path << std::endl;
+    return false;
+  }
+
+  double origin = 0.0;
+  for (const TraceFrame &frame : _trace) {
+    if (!frame.events.empty()) {
+      origin = frame.events.front().beginUs;
+      break;
+    }
+  }
+
+  // Complete ("X") events on one GPU track, timestamps in microseconds
+  file << std::fixed << std::setprecision(3);
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+          "\"args\":{\"name\":\"GPU queue\"}}";
+  for (const TraceFrame &frame : _trace) {
+    for (const TraceEvent &event : frame.events) {
+      file << ",\n{\"name\":\"" << event.name
+           << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+           << event.beginUs - origin
+           << ",\"dur\":" << event.endUs - event.beginUs
+           << ",\"args\":{\"frame\":" << frame.frame << "}}";
+    }
+  }
+  file << "\n]}\n";
+  std::cout << "GPU trace of " << _trace.size() << " frames written to "
+            << path << std::endl;
+  return bool(file);
+}
@@ -0,0 +1,66 @@
+// Vulkan 3DGS - Copyright (c) 2025 Alejandro Amat (github.com/AlejandroAmat) -
+// MIT Licensed
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string &path) {
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return;
+  _file = file;
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    return;
+  _mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (_mapping == nullptr)
+    return;
+  _data = static_cast<const char *>(
+      MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+  if (_data)
+    _size = size_t(size.QuadPart);
+#else
+  _fd = open(path.c_str(), O_RDONLY);
+  if (_fd < 0)
+    return;
+  struct stat st;
+  if (fstat(_fd, &st) != 0 || st.st_size == 0)
+    return;
+  void *ptr = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, _fd, 0);
+  if (ptr == MAP_FAILED)
+    return;
+  madvise(ptr, size_t(st.st_size), MADV_SEQUENTIAL);
+  _data = static_cast<const char *>(ptr);
+  _size = size_t(st.st_size);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+  if (_data)
+    UnmapViewOfFile(_data);
+  if (_mapping)
+    CloseHandle(_mapping);
+  if (_file)
+    CloseHandle(_file);
+#else
+  if (_data)
+    munmap(const_cast<char *>(_data), _size);
+  if (_fd >= 0)
+    close(_fd);
+#endif
+}
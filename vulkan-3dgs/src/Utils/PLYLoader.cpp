@@ -2,10 +2,166 @@
 // MIT Licensed
 
 #include "PLYLoader.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace {
+
+template <typename T> T LoadBytes(const char *src, bool swap) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, src, sizeof(T));
+  if (swap)
+    std::reverse(bytes, bytes + sizeof(T));
+  T value;
+  std::memcpy(&value, bytes, sizeof(T));
+  return value;
+}
+
+template <typename T, bool Swap> float ReadAs(const char *src) {
+  return float(LoadBytes<T>(src, Swap));
+}
+
+struct PLYTypeInfo {
+  const char *names[2];
+  size_t size;
+  float (*read[2])(const char *); // little, big endian
+};
+
+const PLYTypeInfo PLY_TYPES[] = {
+    {{"char", "int8"}, 1, {ReadAs<int8_t, false>, ReadAs<int8_t, true>}},
+    {{"uchar", "uint8"}, 1, {ReadAs<uint8_t, false>, ReadAs<uint8_t, true>}},
+    {{"short", "int16"}, 2, {ReadAs<int16_t, false>, ReadAs<int16_t, true>}},
+    {{"ushort", "uint16"},
+     2,
+     {ReadAs<uint16_t, false>, ReadAs<uint16_t, true>}},
+    {{"int", "int32"}, 4, {ReadAs<int32_t, false>, ReadAs<int32_t, true>}},
+    {{"uint", "uint32"}, 4, {ReadAs<uint32_t, false>, ReadAs<uint32_t, true>}},
+    {{"float", "float32"}, 4, {ReadAs<float, false>, ReadAs<float, true>}},
+    {{"double", "float64"}, 8, {ReadAs<double, false>, ReadAs<double, true>}},
+};
+
+const PLYTypeInfo *FindType(const std::string &name) {
+  for (const auto &type : PLY_TYPES) {
+    if (name == type.names[0] || name == type.names[1])
+      return &type;
+  }
+  return nullptr;
+}
+
+// Record slot of a vertex property, -1 for properties we do not use
+int PropertySlot(const std::string &name) {
+  static const std::pair<const char *, int> fixedSlots[] = {
+      {"x", 0},
+      {"y", 1},
+      {"z", 2},
+      {"nx", 3},
+      {"ny", 4},
+      {"nz", 5},
+      {"f_dc_0", 6},
+      {"f_dc_1", 7},
+      {"f_dc_2", 8},
+      {"opacity", PLY_SLOT_OPACITY},
+      {"scale_0", PLY_SLOT_SCALE + 0},
+      {"scale_1", PLY_SLOT_SCALE + 1},
+      {"scale_2", PLY_SLOT_SCALE + 2},
+      {"rot_0", PLY_SLOT_ROT + 0},
+      {"rot_1", PLY_SLOT_ROT + 1},
+      {"rot_2", PLY_SLOT_ROT + 2},
+      {"rot_3", PLY_SLOT_ROT + 3}};
+  for (const auto &[slotName, slot] : fixedSlots) {
+    if (name == slotName)
+      return slot;
+  }
+  if (name.rfind("f_rest_", 0) == 0) {
+    int index = std::atoi(name.c_str() + 7);
+    if (index >= 0 && index < int(PLY_SLOT_OPACITY - PLY_SLOT_REST))
+      return int(PLY_SLOT_REST) + index;
+  }
+  return -1;
+}
+
+// Records per parallel chunk, large enough to amortize thread start
+const size_t MIN_RECORDS_PER_THREAD = 1 << 16;
+
+// exp(x) for |x| <= 87 to about 1e-7 relative error: 2^n * p(f) with
+// x = n ln2 + f. Branch free (the clamp works on the bits, rounding adds
+// 1.5 * 2^23) so loops calling it vectorize, std::exp stays a libm call
+inline float ExpApprox(float x) {
+  uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  uint32_t magnitude = bits & 0x7FFFFFFFu;
+  magnitude = magnitude > 0x42AE0000u ? 0x42AE0000u : magnitude; // 87.0f
+  bits = (bits & 0x80000000u) | magnitude;
+  std::memcpy(&x, &bits, sizeof(x));
+  float n = (x * 1.44269504f + 12582912.0f) - 12582912.0f;
+  float f = x - n * 0.693145752f - n * 1.42860677e-6f;
+  float p = 1.98756912e-4f;
+  p = p * f + 1.39819994e-3f;
+  p = p * f + 8.33345205e-3f;
+  p = p * f + 4.16657962e-2f;
+  p = p * f + 1.66666657e-1f;
+  p = p * f + 5.0e-1f;
+  p = p * f * f + f + 1.0f;
+  uint32_t scaleBits = uint32_t(int32_t(n) + 127) << 23;
+  float scale;
+  std::memcpy(&scale, &scaleBits, sizeof(scale));
+  return p * scale;
+}
+
+} // namespace
 
 std::unique_ptr<GaussianBase> PLYLoader::LoadPLY(const std::string &path,
-                                                 int &sh_degree) {
+                                                 int &sh_degree,
+                                                 PLYReadMode mode) {
   auto data = std::make_unique<GaussianBase>();
+  PLYSchema schema;
+
+  if (mode == PLYReadMode::Mapped) {
+    MappedFile mapped(path);
+    if (mapped.data() == nullptr) {
+      std::cerr << "Warning: Cannot map PLY file, falling back to stream: "
+                << path << std::endl;
+      return LoadPLY(path, sh_degree, PLYReadMode::Stream);
+    }
+
+    // Header is plain text terminated by "end_header\n"
+    const char marker[] = "end_header\n";
+    const char *end = std::search(mapped.data(), mapped.data() + mapped.size(),
+                                  marker, marker + sizeof(marker) - 1);
+    if (end == mapped.data() + mapped.size()) {
+      std::cerr << "Error: Invalid PLY header" << std::endl;
+      return nullptr;
+    }
+    size_t headerSize = size_t(end - mapped.data()) + sizeof(marker) - 1;
+
+    std::istringstream header(std::string(mapped.data(), headerSize));
+    if (!ParseHeader(header, schema)) {
+      std::cerr << "Error: Invalid PLY header" << std::endl;
+      return nullptr;
+    }
+
+    sh_degree = schema.shDegree;
+    const char *body = mapped.data() + headerSize;
+    size_t bodySize = mapped.size() - headerSize;
+    bool ok = schema.format == PLYFormat::Ascii
+                  ? ReadVertexDataAscii(body, bodySize, schema, *data)
+                  : ReadVertexDataMapped(body, bodySize, schema, *data);
+    if (!ok) {
+      std::cerr << "Error: Failed to read vertex data" << std::endl;
+      return nullptr;
+    }
+
+    std::cout << "Loaded " << data->_numGaussians << " Gaussians from " << path
+              << " (mapped)" << std::endl;
+    return data;
+  }
 
   std::ifstream file(path, std::ios::binary);
   if (!file.is_open()) {
@@ -14,14 +170,22 @@ std::unique_ptr<GaussianBase> PLYLoader::LoadPLY(const std::string &path,
   }
 
   // Parse PLY header
-  if (!ParseHeader(file, *data)) {
+  if (!ParseHeader(file, schema)) {
     std::cerr << "Error: Invalid PLY header" << std::endl;
     return nullptr;
   }
 
-  sh_degree = data->_shDegree;
+  sh_degree = schema.shDegree;
   // Read vertex data
-  if (!ReadVertexData(file, *data)) {
+  bool ok;
+  if (schema.format == PLYFormat::Ascii) {
+    std::string text((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+    ok = ReadVertexDataAscii(text.data(), text.size(), schema, *data);
+  } else {
+    ok = ReadVertexData(file, schema, *data);
+  }
+  if (!ok) {
     std::cerr << "Error: Failed to read vertex data" << std::endl;
     return nullptr;
   }
@@ -31,107 +195,338 @@ std::unique_ptr<GaussianBase> PLYLoader::LoadPLY(const std::string &path,
   return data;
 }
 
-bool PLYLoader::ParseHeader(std::ifstream &file, GaussianBase &data) {
+bool PLYLoader::ParseHeader(std::istream &file, PLYSchema &schema) {
   std::string line;
-  std::vector<std::string> properties;
+  std::string element;
+  bool foundVertex = false;
+  bool sizedBefore = true; // elements before the vertices have a fixed size
+  size_t elementCount = 0;
+  size_t elementStride = 0;
+
+  // Vertex properties in file order: name, type
+  std::vector<std::pair<std::string, const PLYTypeInfo *>> properties;
+
+  auto closeElement = [&]() {
+    if (!foundVertex && !element.empty() && element != "vertex") {
+      schema.vertexOffset += elementCount * elementStride;
+      schema.linesBefore += elementCount;
+    }
+  };
 
   // Read header
   while (std::getline(file, line)) {
-    if (line.find("element vertex") != std::string::npos) {
-      std::istringstream iss(line);
-      std::string element, vertex;
-      size_t count;
-      iss >> element >> vertex >> count;
-      data._numGaussians = count;
-    } else if (line.find("property") != std::string::npos) {
-      properties.push_back(line);
-    } else if (line == "end_header") {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    std::istringstream iss(line);
+    std::string keyword;
+    iss >> keyword;
+
+    if (keyword == "format") {
+      std::string format;
+      iss >> format;
+      if (format == "ascii")
+        schema.format = PLYFormat::Ascii;
+      else if (format == "binary_big_endian")
+        schema.format = PLYFormat::BinaryBigEndian;
+      else if (format == "binary_little_endian")
+        schema.format = PLYFormat::BinaryLittleEndian;
+      else {
+        std::cerr << "Error: Unknown PLY format " << format << std::endl;
+        return false;
+      }
+    } else if (keyword == "element") {
+      closeElement();
+      if (element == "vertex")
+        foundVertex = true;
+      iss >> element >> elementCount;
+      elementStride = 0;
+      if (element == "vertex")
+        schema.numVertices = elementCount;
+    } else if (keyword == "property") {
+      std::string type, name;
+      iss >> type;
+      if (type == "list") {
+        std::string countType, itemType;
+        iss >> countType >> itemType >> name;
+        if (element == "vertex") {
+          std::cerr << "Error: List property " << name << " on vertices"
+                    << std::endl;
+          return false;
+        }
+        if (!foundVertex)
+          sizedBefore = false;
+        continue;
+      }
+      iss >> name;
+      const PLYTypeInfo *info = FindType(type);
+      if (info == nullptr) {
+        std::cerr << "Error: Unknown PLY property type " << type << std::endl;
+        return false;
+      }
+      elementStride += info->size;
+      if (element == "vertex")
+        properties.push_back({name, info});
+    } else if (keyword == "end_header") {
+      break;
+    }
+  }
+  closeElement();
+
+  if (schema.numVertices == 0)
+    return false;
+  if (schema.format != PLYFormat::Ascii && !sizedBefore) {
+    std::cerr << "Error: Variable sized elements before the vertices"
+              << std::endl;
+    return false;
+  }
+
+  // Resolve every vertex property to its record slot once
+  bool swap = schema.format == PLYFormat::BinaryBigEndian;
+  bool found[PLY_RECORD_FLOATS] = {};
+  int restCount = 0;
+  size_t offset = 0;
+  for (uint32_t index = 0; index < properties.size(); ++index) {
+    const auto &[name, info] = properties[index];
+    int slot = PropertySlot(name);
+    if (slot >= 0 && !found[slot]) {
+      found[slot] = true;
+      PLYSchema::Gather gather = {offset, index, uint32_t(slot),
+                                  info->read[swap ? 1 : 0]};
+      if (info == FindType("float") && !swap)
+        schema.copyGathers.push_back(gather);
+      else
+        schema.convertGathers.push_back(gather);
+      if (uint32_t(slot) >= PLY_SLOT_REST && uint32_t(slot) < PLY_SLOT_OPACITY)
+        restCount++;
+    } else if (slot < 0) {
+      std::cout << "PLY: ignoring vertex property " << name << std::endl;
+    }
+    offset += info->size;
+  }
+  schema.stride = offset;
+  schema.numProperties = properties.size();
+
+  const char *required[] = {"x",       "y",       "z",       "f_dc_0",
+                            "f_dc_1",  "f_dc_2",  "opacity", "scale_0",
+                            "scale_1", "scale_2", "rot_0",   "rot_1",
+                            "rot_2",   "rot_3"};
+  for (const char *name : required) {
+    if (!found[PropertySlot(name)]) {
+      std::cerr << "Error: PLY is missing vertex property " << name
+                << std::endl;
+      return false;
+    }
+  }
+
+  // SH degree from the f_rest_* coefficients present: 0, 9, 24 or 45
+  schema.shDegree = 0;
+  for (int degree = 3; degree > 0; --degree) {
+    int needed = 3 * ((degree + 1) * (degree + 1) - 1);
+    bool complete = true;
+    for (int i = 0; i < needed; ++i)
+      complete = complete && found[PLY_SLOT_REST + i];
+    if (complete) {
+      schema.shDegree = degree;
       break;
     }
   }
-  uint32_t numberProperties = properties.size();
-  switch (numberProperties) {
-  case 17:
-    data._shDegree = 0;
-    break;
-  case 26:
-    data._shDegree = 1;
-    break;
-  case 41:
-    data._shDegree = 2;
-    break;
-  case 62:
-    data._shDegree = 3;
-    break;
-  }
-
-  return data._numGaussians > 0;
+  int used = 3 * ((schema.shDegree + 1) * (schema.shDegree + 1) - 1);
+  if (restCount != used) {
+    std::cout << "PLY: " << restCount << " f_rest coefficients, using SH degree "
+              << schema.shDegree << std::endl;
+  }
+
+  // Normals are optional and stay zero when missing
+  return true;
 }
 
-bool PLYLoader::ReadVertexData(std::ifstream &file, GaussianBase &data) {
-  const size_t num_gaussians = data._numGaussians;
-  const int shDegree = data._shDegree;
-  const int sh_coeffs_per_channel = (shDegree + 1) * (shDegree + 1);
-  const int total_sh_coeffs = 3 * sh_coeffs_per_channel;   // 3 channels (RGB)
-  const int rest_coeffs = 3 * (sh_coeffs_per_channel - 1); // Exclude DC
+void PLYLoader::AllocateData(const PLYSchema &schema, GaussianBase &data) {
+  const size_t num_gaussians = schema.numVertices;
+  const int sh_coeffs_per_channel =
+      (schema.shDegree + 1) * (schema.shDegree + 1);
 
-  // Resize vectors
+  data._numGaussians = num_gaussians;
+  data._shDegree = schema.shDegree;
   data._xyz.resize(num_gaussians);
   data._normals.resize(num_gaussians);
-  data._shCoefficients.resize(num_gaussians * total_sh_coeffs);
+  data._shCoefficients.resize(num_gaussians * 3 * sh_coeffs_per_channel);
   data._opacities.resize(num_gaussians);
   data._scales.resize(num_gaussians);
   data._rotations.resize(num_gaussians);
+}
+
+bool PLYLoader::ReadVertexData(std::ifstream &file, const PLYSchema &schema,
+                               GaussianBase &data) {
+  AllocateData(schema, data);
+  file.seekg(std::streamoff(schema.vertexOffset), std::ios::cur);
 
-  for (size_t i = 0; i < num_gaussians; ++i) {
-    // Position
-    file.read(reinterpret_cast<char *>(&data._xyz[i]), sizeof(glm::vec3));
-    data._xyz[i].w = 1.0f;
-    // Normals
-    file.read(reinterpret_cast<char *>(&data._normals[i]), sizeof(glm::vec3));
-
-    // DC SH coefficients (f_dc_0, f_dc_1, f_dc_2)
-    glm::vec3 dc_coeffs;
-    file.read(reinterpret_cast<char *>(&dc_coeffs), sizeof(glm::vec3));
-
-    // Rest SH coefficients - read only what exists in PLY
-    std::vector<float> rest_coeffs_vector(rest_coeffs);
-    file.read(reinterpret_cast<char *>(rest_coeffs_vector.data()),
-              rest_coeffs * sizeof(float));
-
-    // Store in combined SH array
-    size_t sh_offset = i * total_sh_coeffs;
-
-    // Store DC coefficients
-    data._shCoefficients[sh_offset + 0] = dc_coeffs.x; // f_dc_0
-    data._shCoefficients[sh_offset + 1] = dc_coeffs.y; // f_dc_1
-    data._shCoefficients[sh_offset + 2] = dc_coeffs.z; // f_dc_2
-
-    // Store rest coefficients
-    for (int j = 0; j < rest_coeffs / 3; ++j) {
-      int out_idx = (j + 1) * 3; // +1 because DC is at index 0
-      data._shCoefficients[sh_offset + out_idx + 0] =
-          rest_coeffs_vector[j]; // R
-      data._shCoefficients[sh_offset + out_idx + 1] =
-          rest_coeffs_vector[j + (rest_coeffs / 3)]; // G
-      data._shCoefficients[sh_offset + out_idx + 2] =
-          rest_coeffs_vector[j + 2 * (rest_coeffs / 3)]; // B
+  // Fixed number of records per read, the buffer is reused for every chunk
+  const size_t chunkRecords = MIN_RECORDS_PER_THREAD;
+  std::vector<char> buffer(chunkRecords * schema.stride);
+  for (size_t first = 0; first < schema.numVertices; first += chunkRecords) {
+    size_t last = std::min(first + chunkRecords, schema.numVertices);
+    file.read(buffer.data(), std::streamsize((last - first) * schema.stride));
+    if (size_t(file.gcount()) != (last - first) * schema.stride) {
+      std::cerr << "Error: PLY truncated at vertex " << first << std::endl;
+      return false;
     }
+    DecodeRecords(buffer.data(), first, last, schema, data);
+    ApplyActivations(first, last, data);
+  }
+  return true;
+}
+
+bool PLYLoader::ReadVertexDataMapped(const char *body, size_t size,
+                                     const PLYSchema &schema,
+                                     GaussianBase &data) {
+  const size_t num_gaussians = schema.numVertices;
+  const size_t needed = schema.vertexOffset + num_gaussians * schema.stride;
+  if (size < needed) {
+    std::cerr << "Error: PLY truncated, expected " << needed
+              << " bytes of element data, found " << size << std::endl;
+    return false;
+  }
+  AllocateData(schema, data);
+  const char *records = body + schema.vertexOffset;
 
-    // Read raw values, apply activations, and store directly
-    float rawOpacity;
-    glm::vec3 rawScales;
-    glm::vec4 rawRotation;
+  // Every record has a fixed size, so chunks decode independently straight
+  // into the final arrays
+  auto decode = [&](size_t first, size_t last) {
+    DecodeRecords(records + first * schema.stride, first, last, schema, data);
+    ApplyActivations(first, last, data);
+  };
 
-    file.read(reinterpret_cast<char *>(&rawOpacity), sizeof(float));
-    file.read(reinterpret_cast<char *>(&rawScales), sizeof(glm::vec3));
-    file.read(reinterpret_cast<char *>(&rawRotation), sizeof(glm::vec4));
+  size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+  numThreads = std::min(numThreads, (num_gaussians + MIN_RECORDS_PER_THREAD -
+                                     1) / MIN_RECORDS_PER_THREAD);
+  if (numThreads <= 1) {
+    decode(0, num_gaussians);
+    return true;
+  }
 
-    // Apply activations and store with original names
-    data._opacities[i] = 1.0f / (1.0f + std::exp(-rawOpacity)); // Sigmoid
-    data._scales[i] = glm::vec4(glm::exp(rawScales), 0.0f);
-    data._rotations[i] = glm::normalize(rawRotation);
+  std::vector<std::thread> workers;
+  workers.reserve(numThreads);
+  size_t chunk = (num_gaussians + numThreads - 1) / numThreads;
+  for (size_t t = 0; t < numThreads; ++t) {
+    size_t first = t * chunk;
+    size_t last = std::min(first + chunk, num_gaussians);
+    if (first >= last)
+      break;
+    workers.emplace_back(decode, first, last);
   }
+  for (auto &worker : workers)
+    worker.join();
+  return true;
+}
+
+bool PLYLoader::ReadVertexDataAscii(const char *text, size_t size,
+                                    const PLYSchema &schema,
+                                    GaussianBase &data) {
+  AllocateData(schema, data);
+  const char *cursor = text;
+  const char *end = text + size;
+
+  auto nextLine = [&]() {
+    while (cursor < end && *cursor != '\n')
+      ++cursor;
+    if (cursor < end)
+      ++cursor;
+  };
+  for (size_t i = 0; i < schema.linesBefore; ++i)
+    nextLine();
+
+  // strtof needs terminated input, each line is copied out first
+  std::string line;
+  std::vector<float> values(schema.numProperties);
+  float record[PLY_RECORD_FLOATS];
+  for (size_t i = 0; i < schema.numVertices; ++i) {
+    const char *lineStart = cursor;
+    nextLine();
+    line.assign(lineStart, cursor);
+
+    const char *p = line.c_str();
+    for (size_t v = 0; v < schema.numProperties; ++v) {
+      char *next;
+      values[v] = std::strtof(p, &next);
+      if (next == p) {
+        std::cerr << "Error: Bad ASCII PLY vertex " << i << std::endl;
+        return false;
+      }
+      p = next;
+    }
+
+    std::memcpy(record, schema.defaults, sizeof(record));
+    for (const auto &gather : schema.copyGathers)
+      record[gather.slot] = values[gather.srcIndex];
+    for (const auto &gather : schema.convertGathers)
+      record[gather.slot] = values[gather.srcIndex];
+    StoreRecord(record, i, schema.shDegree, data);
+  }
+  ApplyActivations(0, schema.numVertices, data);
+  return true;
+}
+
+void PLYLoader::DecodeRecords(const char *block, size_t first, size_t last,
+                              const PLYSchema &schema, GaussianBase &data) {
+  float record[PLY_RECORD_FLOATS];
+  for (size_t i = first; i < last; ++i) {
+    const char *src = block + (i - first) * schema.stride;
+    std::memcpy(record, schema.defaults, sizeof(record));
+    for (const auto &gather : schema.copyGathers)
+      std::memcpy(&record[gather.slot], src + gather.srcOffset, sizeof(float));
+    for (const auto &gather : schema.convertGathers)
+      record[gather.slot] = gather.read(src + gather.srcOffset);
+    StoreRecord(record, i, schema.shDegree, data);
+  }
+}
+
+void PLYLoader::StoreRecord(const float *record, size_t i, int shDegree,
+                            GaussianBase &data) {
+  const int sh_coeffs_per_channel = (shDegree + 1) * (shDegree + 1);
+  const int total_sh_coeffs = 3 * sh_coeffs_per_channel;
+  const int rest_per_channel = sh_coeffs_per_channel - 1;
+
+  data._xyz[i] = glm::vec4(record[0], record[1], record[2], 1.0f);
+  data._normals[i] = glm::vec3(record[3], record[4], record[5]);
+
+  // f_rest is stored channel-major, interleave it into RGB triplets
+  float *out = data._shCoefficients.data() + i * total_sh_coeffs;
+  out[0] = record[6];
+  out[1] = record[7];
+  out[2] = record[8];
+  const float *rest = record + PLY_SLOT_REST;
+  for (int j = 0; j < rest_per_channel; ++j) {
+    out[(j + 1) * 3 + 0] = rest[j];
+    out[(j + 1) * 3 + 1] = rest[j + rest_per_channel];
+    out[(j + 1) * 3 + 2] = rest[j + 2 * rest_per_channel];
+  }
+
+  data._opacities[i] = record[PLY_SLOT_OPACITY];
+  data._scales[i] =
+      glm::vec4(record[PLY_SLOT_SCALE], record[PLY_SLOT_SCALE + 1],
+                record[PLY_SLOT_SCALE + 2], 0.0f);
+  data._rotations[i] =
+      glm::vec4(record[PLY_SLOT_ROT], record[PLY_SLOT_ROT + 1],
+                record[PLY_SLOT_ROT + 2], record[PLY_SLOT_ROT + 3]);
+}
+
+// Activations as separate passes over contiguous arrays so the compiler can
+// vectorize them. The exp passes use ExpApprox, the normalize pass has a
+// sqrt that only vectorizes with -fno-math-errno
+void PLYLoader::ApplyActivations(size_t first, size_t last,
+                                 GaussianBase &data) {
+  float *opacities = data._opacities.data();
+  glm::vec4 *scales = data._scales.data();
+  glm::vec4 *rotations = data._rotations.data();
 
-  return file.good() || file.eof();
+  for (size_t i = first; i < last; ++i)
+    opacities[i] = 1.0f / (1.0f + ExpApprox(-opacities[i])); // Sigmoid
+  // Scales as a flat float array, the w padding is cleared afterwards
+  float *scaleComponents = reinterpret_cast<float *>(scales);
+  for (size_t i = first * 4; i < last * 4; ++i)
+    scaleComponents[i] = ExpApprox(scaleComponents[i]);
+  for (size_t i = first; i < last; ++i)
+    scales[i].w = 0.0f;
+  for (size_t i = first; i < last; ++i)
+    rotations[i] = glm::normalize(rotations[i]);
 }
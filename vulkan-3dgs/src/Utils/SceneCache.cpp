@@ -0,0 +1,152 @@
+// Vulkan 3DGS - Copyright (c) 2025 Alejandro Amat (github.com/AlejandroAmat) -
+// MIT Licensed
+
+#include "SceneCache.h"
+#include "MappedFile.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+uint64_t AlignUp(uint64_t value) {
+  return (value + SCENE_CACHE_ALIGNMENT - 1) & ~(SCENE_CACHE_ALIGNMENT - 1);
+}
+
+} // namespace
+
+bool SceneCache::IsCacheFile(const std::string &path) {
+  return std::filesystem::path(path).extension() == ".3dgsbin";
+}
+
+std::string SceneCache::CachePathFor(const std::string &plyPath) {
+  return std::filesystem::path(plyPath).replace_extension(".3dgsbin").string();
+}
+
+bool SceneCache::SourceStamp(const std::string &sourcePath, uint64_t &size,
+                             int64_t &modified) {
+  std::error_code error;
+  size = std::filesystem::file_size(sourcePath, error);
+  if (error)
+    return false;
+  auto time = std::filesystem::last_write_time(sourcePath, error);
+  if (error)
+    return false;
+  modified = int64_t(time.time_since_epoch().count());
+  return true;
+}
+
+std::unique_ptr<GaussianBase>
+SceneCache::Load(const std::string &cachePath, const std::string &sourcePath) {
+  auto mapping = std::make_shared<MappedFile>(cachePath);
+  if (mapping->data() == nullptr ||
+      mapping->size() < sizeof(SceneCacheHeader))
+    return nullptr;
+
+  SceneCacheHeader header;
+  std::memcpy(&header, mapping->data(), sizeof(header));
+  if (std::memcmp(header.magic, SCENE_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != SCENE_CACHE_VERSION || header.shDegree > 3) {
+    std::cerr << "Warning: Ignoring unknown scene cache " << cachePath
+              << std::endl;
+    return nullptr;
+  }
+
+  if (!sourcePath.empty()) {
+    uint64_t size;
+    int64_t modified;
+    if (SourceStamp(sourcePath, size, modified) &&
+        (size != header.sourceSize || modified != header.sourceModified)) {
+      std::cout << "Scene cache " << cachePath << " is stale" << std::endl;
+      return nullptr;
+    }
+  }
+
+  auto data = std::make_unique<GaussianBase>();
+  data->_numGaussians = header.numGaussians;
+  data->_shDegree = int(header.shDegree);
+
+  const uint64_t n = header.numGaussians;
+  const uint64_t expected[GAUSSIAN_ARRAY_COUNT] = {
+      n * sizeof(glm::vec4), n * sizeof(glm::vec4), n * sizeof(glm::vec4),
+      n * sizeof(float),
+      n * 3 * uint64_t(data->GetSHCoefficientsPerChannel()) * sizeof(float)};
+  for (int i = 0; i < GAUSSIAN_ARRAY_COUNT; ++i) {
+    const auto &array = header.arrays[i];
+    if (array.size != expected[i] || array.offset % SCENE_CACHE_ALIGNMENT ||
+        array.offset + array.size > mapping->size()) {
+      std::cerr << "Warning: Corrupt scene cache " << cachePath << std::endl;
+      return nullptr;
+    }
+    data->_mappedArrays[i] = mapping->data() + array.offset;
+  }
+  data->_mapping = std::move(mapping);
+
+  std::cout << "Loaded " << data->_numGaussians << " Gaussians from "
+            << cachePath << " (scene cache)" << std::endl;
+  return data;
+}
+
+bool SceneCache::Write(const std::string &cachePath,
+                       const std::string &sourcePath,
+                       const GaussianBase &data) {
+  SceneCacheHeader header = {};
+  std::memcpy(header.magic, SCENE_CACHE_MAGIC, sizeof(header.magic));
+  header.version = SCENE_CACHE_VERSION;
+  header.shDegree = uint32_t(data.GetSHDegree());
+  header.numGaussians = data.GetCount();
+  if (!SourceStamp(sourcePath, header.sourceSize, header.sourceModified))
+    return false;
+
+  const uint64_t n = header.numGaussians;
+  const void *arrays[GAUSSIAN_ARRAY_COUNT] = {
+      data.GetPositionsData(), data.GetScalesData(), data.GetRotationsData(),
+      data.GetOpacitiesData(), data.GetSHData()};
+  const uint64_t sizes[GAUSSIAN_ARRAY_COUNT] = {
+      n * sizeof(glm::vec4), n * sizeof(glm::vec4), n * sizeof(glm::vec4),
+      n * sizeof(float),
+      n * 3 * uint64_t(data.GetSHCoefficientsPerChannel()) * sizeof(float)};
+
+  uint64_t offset = AlignUp(sizeof(header));
+  for (int i = 0; i < GAUSSIAN_ARRAY_COUNT; ++i) {
+    header.arrays[i] = {offset, sizes[i]};
+    offset = AlignUp(offset + sizes[i]);
+  }
+
+  // Written under a temporary name so an interrupted write never leaves a
+  // truncated cache behind
+  std::string tempPath = cachePath + ".tmp";
+  {
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      std::cerr << "Warning: Cannot write scene cache " << cachePath
+                << std::endl;
+      return false;
+    }
+    const char zeros[SCENE_CACHE_ALIGNMENT] = {};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    uint64_t written = sizeof(header);
+    for (int i = 0; i < GAUSSIAN_ARRAY_COUNT; ++i) {
+      file.write(zeros, std::streamsize(header.arrays[i].offset - written));
+      file.write(static_cast<const char *>(arrays[i]),
+                 std::streamsize(sizes[i]));
+      written = header.arrays[i].offset + sizes[i];
+    }
+    if (!file.good()) {
+      file.close();
+      std::filesystem::remove(tempPath);
+      return false;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(tempPath, cachePath, error);
+  if (error) {
+    std::filesystem::remove(tempPath, error);
+    return false;
+  }
+  std::cout << "Wrote scene cache " << cachePath << std::endl;
+  return true;
+}
@@ -1,12 +1,120 @@
 #include "entrypoint_python.h"
+#include "Application.h"
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+namespace py = pybind11;
+using FloatArray =
+    py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+namespace {
+
+// numpy is row major, glm column major
+template <int N> glm::mat<N, N, float> ToMatrix(const FloatArray &array,
+                                                const char *name) {
+  if (array.ndim() != 2 || array.shape(0) != N || array.shape(1) != N)
+    throw py::value_error(std::string(name) + " must be " +
+                          std::to_string(N) + "x" + std::to_string(N));
+  auto values = array.unchecked<2>();
+  glm::mat<N, N, float> matrix;
+  for (int row = 0; row < N; row++)
+    for (int col = 0; col < N; col++)
+      matrix[col][row] = values(row, col);
+  return matrix;
+}
+
+// Rows of floats per Gaussian, any shape with count rows
+size_t RowWidth(const FloatArray &array, const char *name, size_t count) {
+  if (array.ndim() < 1 || size_t(array.shape(0)) != count || count == 0)
+    throw py::value_error(std::string(name) + " needs one row per Gaussian");
+  return size_t(array.size()) / count;
+}
+
+} // namespace
+
 PYBIND11_MODULE(vulkan_3dgs_py, m) {
   m.def("run", &renderGaussians, "Run the 3D Gaussian Splatting application",
-        pybind11::arg("path"), 
+        pybind11::arg("path"),
         pybind11::arg("shader_dir"),
-        pybind11::arg("width") = pybind11::none(), 
+        pybind11::arg("width") = pybind11::none(),
         pybind11::arg("height") = pybind11::none()
   );
-}
\ No newline at end of file
+
+  py::class_<SceneRenderer>(
+      m, "Renderer",
+      "Headless renderer holding one uploaded scene. render() returns a "
+      "read-only (height, width, 4) uint8 view of the mapped readback "
+      "memory, overwritten two renders later: copy() it to keep it")
+      .def(py::init([](const std::string &path, const std::string &shaderDir,
+                       uint32_t width, uint32_t height) {
+             auto scene = Application::LoadScene(path);
+             if (!scene)
+               throw std::runtime_error("Failed to load " + path);
+             return std::make_unique<SceneRenderer>(std::move(scene),
+                                                    shaderDir, width, height);
+           }),
+           py::arg("path"), py::arg("shader_dir"), py::arg("width"),
+           py::arg("height"))
+      .def_static(
+          "from_arrays",
+          [](const FloatArray &means, const FloatArray &scales,
+             const FloatArray &rotations, const FloatArray &opacities,
+             const FloatArray &sh, const std::string &shaderDir,
+             uint32_t width, uint32_t height, bool activated) {
+            size_t count = size_t(means.ndim() > 0 ? means.shape(0) : 0);
+            if (RowWidth(means, "means", count) != 3 ||
+                RowWidth(scales, "scales", count) != 3 ||
+                RowWidth(rotations, "rotations", count) != 4 ||
+                RowWidth(opacities, "opacities", count) != 1)
+              throw py::value_error("Expected means (N, 3), scales (N, 3), "
+                                    "rotations (N, 4) wxyz, opacities (N,)");
+            size_t shValues = RowWidth(sh, "sh", count);
+            if (shValues % 3 != 0)
+              throw py::value_error("sh must be (N, K, 3)");
+
+            auto scene = GaussianBase::FromArrays(
+                count, means.data(), scales.data(), rotations.data(),
+                opacities.data(), sh.data(), int(shValues / 3), activated);
+            return std::make_unique<SceneRenderer>(std::move(scene),
+                                                   shaderDir, width, height);
+          },
+          "Scene from training tensors. Unless activated, scales are log "
+          "and opacities logits as in a PLY",
+          py::arg("means"), py::arg("scales"), py::arg("rotations"),
+          py::arg("opacities"), py::arg("sh"), py::arg("shader_dir"),
+          py::arg("width"), py::arg("height"), py::arg("activated") = false)
+      .def(
+          "render",
+          [](py::object self, const FloatArray &view, const FloatArray &proj,
+             std::optional<uint32_t> width, std::optional<uint32_t> height) {
+            SceneRenderer &renderer = self.cast<SceneRenderer &>();
+            uint32_t w = renderer.GetWidth(), h = renderer.GetHeight();
+            if (width.value_or(w) != w || height.value_or(h) != h)
+              throw py::value_error("Renderer was created for " +
+                                    std::to_string(w) + "x" +
+                                    std::to_string(h));
+            glm::mat4 viewMatrix = ToMatrix<4>(view, "view");
+            glm::mat3 intrinsics = ToMatrix<3>(proj, "proj");
+
+            const ReadbackFrame *frame;
+            {
+              py::gil_scoped_release release;
+              frame = &renderer.Render(viewMatrix, intrinsics);
+            }
+            // No copy, the renderer stays alive as the array's base
+            py::array_t<uint8_t> image(
+                {size_t(h), size_t(w), size_t(4)},
+                {size_t(w) * 4, size_t(4), size_t(1)}, frame->rgba, self);
+            image.attr("setflags")(py::arg("write") = false);
+            return image;
+          },
+          "view: 4x4 world to camera (x right, y down, z forward), "
+          "proj: 3x3 pinhole intrinsics in pixels",
+          py::arg("view"), py::arg("proj"), py::arg("width") = py::none(),
+          py::arg("height") = py::none())
+      .def_property_readonly("width", &SceneRenderer::GetWidth)
+      .def_property_readonly("height", &SceneRenderer::GetHeight)
+      .def_property_readonly("num_gaussians",
+                             &SceneRenderer::GetGaussianCount);
+}
@@ -44,3 +44,54 @@ void renderGaussians(const std::string path, const std::string& shaderDir, std::
   glfwTerminate();
   return;
 }
+
+SceneRenderer::SceneRenderer(std::unique_ptr<GaussianBase> scene,
+                             const std::string &shaderDir, uint32_t width,
+                             uint32_t height)
+    : _width(width), _height(height) {
+  if (!scene)
+    throw std::runtime_error("Cannot render a null scene");
+  g_renderSettings.shaderPath = shaderDir;
+  g_renderSettings.width = int(width);
+  g_renderSettings.height = int(height);
+
+  int degree = scene->GetSHDegree();
+  _context.emplace(VkExtent2D{width, height}, uint32_t(frames_in_flight));
+  if (_context->InitContext() != 0)
+    throw std::runtime_error("Failed to initialize the Vulkan context");
+
+  _renderer.emplace(*_context, degree, _sequence);
+  _renderer->InitializeCamera(float(width), float(height));
+  // Dataset views, not the interactive camera's far plane
+  BatchOptions clipping;
+  g_renderSettings.nearPlane = clipping.nearPlane;
+  g_renderSettings.farPlane = clipping.farPlane;
+  _renderer->LoadGaussianData(std::move(scene));
+  _renderer->CreateBuffers();
+  _renderer->InitComputePipeline();
+  _renderer->SetReadbackCallback(
+      [this](const ReadbackFrame &frame) { _last = frame; });
+}
+
+const ReadbackFrame &SceneRenderer::Render(const glm::mat4 &view,
+                                           const glm::mat3 &intrinsics) {
+  BatchView camera;
+  camera.width = _width;
+  camera.height = _height;
+  camera.fx = intrinsics[0][0];
+  camera.fy = intrinsics[1][1];
+  camera.cx = intrinsics[2][0];
+  camera.cy = intrinsics[2][1];
+  camera.rotation = glm::mat3(view);
+  camera.translation = glm::vec3(view[3]);
+
+  // Synchronous, so the key count is exact and nothing is dropped
+  _last = {};
+  _renderer->RenderView(BatchRenderer::MakeUniforms(
+      camera, _width, _height, g_renderSettings.nearPlane,
+      g_renderSettings.farPlane));
+  _renderer->FlushReadbacks();
+  if (!_last.rgba)
+    throw std::runtime_error("Frame was not read back");
+  return _last;
+}
@@ -5,10 +5,19 @@ echo "Compiling shaders for linux..."
 # Compile standard shaders (shaders in src/Shaders/)
 glslangValidator -V --target-env spirv1.3 ../Shaders/debug.comp -o ../Shaders/debug.spv
 glslangValidator -V --target-env spirv1.3 ../Shaders/preprocess.comp -o ../Shaders/preprocess.spv
+glslangValidator -V --target-env spirv1.3 -DPACKED_GAUSSIAN_LAYOUT ../Shaders/preprocess.comp -o ../Shaders/preprocess_packed.spv
+glslangValidator -V --target-env spirv1.3 ../Shaders/covariance.comp -o ../Shaders/covariance.spv
+glslangValidator -V --target-env spirv1.3 -DPACKED_GAUSSIAN_LAYOUT ../Shaders/covariance.comp -o ../Shaders/covariance_packed.spv
+glslangValidator -V --target-env spirv1.3 ../Shaders/cluster_cull.comp -o ../Shaders/cluster_cull.spv
 glslangValidator -V --target-env spirv1.3 ../Shaders/debugGaussians.comp -o ../Shaders/nearest.spv
 glslangValidator -V --target-env spirv1.3 ../Shaders/prefixsum.comp -o ../Shaders/sum.spv
+glslangValidator -V --target-env spirv1.3 ../../benchmarks/shaders/prefixsum_hillis.comp -o ../Shaders/prefixsum_hillis.spv
 glslangValidator -V --target-env spirv1.5 ../Shaders/idkeys.comp -o ../Shaders/idkeys.spv
+glslangValidator -V --target-env spirv1.5 -DBITS=32 ../Shaders/idkeys.comp -o ../Shaders/idkeys32.spv
 glslangValidator -V --target-env spirv1.3 ../Shaders/tile_boundaries.comp -o ../Shaders/boundaries.spv
+glslangValidator -V --target-env spirv1.3 -DBITS=32 ../Shaders/tile_boundaries.comp -o ../Shaders/boundaries32.spv
+glslangValidator -V --target-env spirv1.3 ../Shaders/dispatch_args.comp -o ../Shaders/dispatch_args.spv
+glslangValidator -V --target-env spirv1.3 ../Shaders/depth_budget.comp -o ../Shaders/depth_budget.spv
 glslangValidator -V --target-env spirv1.5 ../Shaders/render_shared_mem.comp -o ../Shaders/render_shared.spv
 glslangValidator -V --target-env spirv1.5 ../Shaders/upsample.comp -o ../Shaders/upsample.spv
 glslangValidator -V --target-env spirv1.5 ../Shaders/vertex_axis.vert -o ../Shaders/axis_vert.spv
@@ -17,6 +26,14 @@ glslangValidator -V --target-env spirv1.5 ../Shaders/frag_axis.frag -o ../Shader
 
 glslangValidator -V --target-env spirv1.5  ../Shaders/radix_sort/radixsort.comp -o ../Shaders/sort.spv
 glslangValidator -V --target-env spirv1.5  ../Shaders/radix_sort/histogram.comp -o ../Shaders/histogram.spv
+glslangValidator -V --target-env spirv1.5 -DBITS=32 ../Shaders/radix_sort/radixsort.comp -o ../Shaders/sort32.spv
+glslangValidator -V --target-env spirv1.5 -DBITS=32 ../Shaders/radix_sort/histogram.comp -o ../Shaders/histogram32.spv
+glslangValidator -V --target-env spirv1.5  ../Shaders/radix_sort/histogram_scan.comp -o ../Shaders/histogram_scan.spv
+glslangValidator -V --target-env spirv1.5 -DBITS=32 -DHISTOGRAM_WALK ../Shaders/radix_sort/radixsort.comp -o ../Shaders/sort_walk32.spv
+glslangValidator -V --target-env spirv1.5 ../Shaders/radix_sort/onesweep_histogram.comp -o ../Shaders/onesweep_histogram.spv
+glslangValidator -V --target-env spirv1.5 ../Shaders/radix_sort/onesweep.comp -o ../Shaders/onesweep.spv
+glslangValidator -V --target-env spirv1.5 -DBITS=32 ../Shaders/radix_sort/onesweep_histogram.comp -o ../Shaders/onesweep_histogram32.spv
+glslangValidator -V --target-env spirv1.5 -DBITS=32 ../Shaders/radix_sort/onesweep.comp -o ../Shaders/onesweep32.spv
 glslangValidator -V --target-env spirv1.5  ../Shaders/render.comp -o ../Shaders/render.spv
 
 echo "macOS shader compilation complete!"